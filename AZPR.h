@@ -24,9 +24,14 @@
 namespace llvm {
   class AZPRTargetMachine;
   class FunctionPass;
+  class Pass;
 
   FunctionPass *createAZPRISelDag(AZPRTargetMachine &TM);
   FunctionPass *createAZPRDelaySlotFillerPass(TargetMachine &tm);
+  FunctionPass *createAZPRConstantAnchorPass(TargetMachine &tm);
+  FunctionPass *createAZPRSoftwarePipelinerPass(TargetMachine &tm);
+  FunctionPass *createAZPRCountDownLoopsPass();
+  Pass *createAZPRRuntimeUnrollPass(unsigned Threshold);
 } // end namespace llvm;
 
 #endif
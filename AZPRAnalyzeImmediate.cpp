@@ -0,0 +1,78 @@
+//===-- AZPRAnalyzeImmediate.cpp - Analyze Immediates ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AZPRAnalyzeImmediate.h"
+#include "MCTargetDesc/AZPRMCTargetDesc.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace llvm;
+
+void AZPRAnalyzeImmediate::GetShortestSeq(const InstSeq &Seq) {
+  if (Insts.empty() || Seq.size() < Insts.size())
+    Insts = Seq;
+}
+
+const AZPRAnalyzeImmediate::InstSeq &
+AZPRAnalyzeImmediate::Analyze(uint32_t Imm) {
+  int32_t SImm = (int32_t)Imm;
+  InstSeq Seq;
+
+  Insts.clear();
+
+  // 1命令: ADDUIは符号拡張, XORIはゼロ拡張
+  if (isInt<16>(SImm)) {
+    Insts.push_back(Inst(AZPR::ADDUI, SImm));
+    return Insts;
+  }
+  if (isUInt<16>(Imm)) {
+    Insts.push_back(Inst(AZPR::XORI, Imm));
+    return Insts;
+  }
+
+  // 上位16bitが全部1: 符号拡張した値の下位をXORIで書き換える
+  if ((Imm >> 16) == 0xFFFF) {
+    Seq.clear();
+    Seq.push_back(Inst(AZPR::ADDUI, -1));
+    Seq.push_back(Inst(AZPR::XORI, ~Imm & 0xFFFF));
+    GetShortestSeq(Seq);
+  }
+
+  // 16bitの値を左シフトしたもの
+  unsigned TZ = CountTrailingZeros_32(Imm);
+  if (isUInt<16>(Imm >> TZ)) {
+    Seq.clear();
+    Seq.push_back(Inst(AZPR::XORI, Imm >> TZ));
+    Seq.push_back(Inst(AZPR::SHLLI, TZ));
+    GetShortestSeq(Seq);
+  }
+  if (isInt<16>(SImm >> TZ)) {
+    Seq.clear();
+    Seq.push_back(Inst(AZPR::ADDUI, SImm >> TZ));
+    Seq.push_back(Inst(AZPR::SHLLI, TZ));
+    GetShortestSeq(Seq);
+  }
+
+  // 符号拡張した値を論理右シフトしたもの(0x00FFFFFFなどのマスク)
+  unsigned LZ = CountLeadingZeros_32(Imm);
+  if (LZ > 0 && isInt<16>((int32_t)(Imm << LZ))) {
+    Seq.clear();
+    Seq.push_back(Inst(AZPR::ADDUI, (int32_t)(Imm << LZ)));
+    Seq.push_back(Inst(AZPR::SHRLI, LZ));
+    GetShortestSeq(Seq);
+  }
+
+  // 一般の場合: 上位16bitをロードしてシフトし, 下位16bitをORする
+  if (Insts.empty()) {
+    Insts.push_back(Inst(AZPR::XORI, Imm >> 16));
+    Insts.push_back(Inst(AZPR::SHLLI, 16));
+    Insts.push_back(Inst(AZPR::ORI, Imm & 0xFFFF));
+  }
+
+  return Insts;
+}
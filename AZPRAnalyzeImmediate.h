@@ -0,0 +1,47 @@
+//===-- AZPRAnalyzeImmediate.h - Analyze Immediates ------------*- C++ -*--===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a helper that finds the shortest instruction sequence
+// which materializes a 32-bit immediate in a register.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AZPR_ANALYZE_IMMEDIATE_H
+#define AZPR_ANALYZE_IMMEDIATE_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+  class AZPRAnalyzeImmediate {
+  public:
+    struct Inst {
+      unsigned Opc;
+      int64_t ImmOpnd;
+      Inst(unsigned Opc, int64_t ImmOpnd) : Opc(Opc), ImmOpnd(ImmOpnd) {}
+    };
+    typedef SmallVector<Inst, 3> InstSeq;
+
+    /// Analyze - Get an instruction sequence to load immediate Imm. The first
+    /// instruction reads r0, each following one reads the previous result.
+    const InstSeq &Analyze(uint32_t Imm);
+
+    /// getCost - Number of instructions needed to load Imm.
+    unsigned getCost(uint32_t Imm) { return Analyze(Imm).size(); }
+
+  private:
+    /// GetShortestSeq - Keep the shortest of Insts and Seq in Insts.
+    void GetShortestSeq(const InstSeq &Seq);
+
+    InstSeq Insts;
+  };
+}
+
+#endif
@@ -32,6 +32,8 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/Target/Mangler.h"
+#include "llvm/Target/TargetLoweringObjectFile.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/TargetRegistry.h"
 using namespace llvm;
 
@@ -48,6 +50,8 @@ class AZPRAsmPrinter : public AsmPrinter {
   // should overwrite functions
   void EmitInstruction(const MachineInstr *MI) /*override*/;
 
+  virtual void EmitConstantPool();
+
   virtual bool isBlockOnlyReachableByFallthrough(const MachineBasicBlock*
                                                  MBB) const;
 
@@ -67,6 +71,25 @@ EmitInstruction(const MachineInstr *MI) {
   OutStreamer.EmitInstruction(TmpInst);
 }
 
+/// EmitConstantPool - プールの定数はベースからの差分でアクセスするので,
+/// マージ可能なセクションに分けずに.rodataに順番に並べる
+void AZPRAsmPrinter::EmitConstantPool() {
+  const MachineConstantPool *MCP = MF->getConstantPool();
+  const std::vector<MachineConstantPoolEntry> &CP = MCP->getConstants();
+  if (CP.empty()) return;
+
+  OutStreamer.SwitchSection(getObjFileLowering().getReadOnlySection());
+  for (unsigned i = 0, e = CP.size(); i != e; ++i) {
+    const MachineConstantPoolEntry &CPE = CP[i];
+    EmitAlignment(Log2_32(CPE.getAlignment()));
+    OutStreamer.EmitLabel(GetCPISymbol(i));
+    if (CPE.isMachineConstantPoolEntry())
+      EmitMachineConstantPoolValue(CPE.Val.MachineCPVal);
+    else
+      EmitGlobalConstant(CPE.Val.ConstVal);
+  }
+}
+
 bool AZPRAsmPrinter::isBlockOnlyReachableByFallthrough(const MachineBasicBlock*
                                                        MBB) const {
   // The predecessor has to be immediately before this block.
@@ -13,15 +13,20 @@
 
 #define DEBUG_TYPE "azpr-isel"
 #include "AZPR.h"
+#include "AZPRAnalyzeImmediate.h"
+#include "AZPRMachineFunction.h"
 #include "AZPRRegisterInfo.h"
 #include "AZPRSubtarget.h"
 #include "AZPRTargetMachine.h"
+#include "MCTargetDesc/AZPRBaseInfo.h"
 #include "MCTargetDesc/AZPRMCTargetDesc.h"
+#include "llvm/Constants.h"
 #include "llvm/GlobalValue.h"
 #include "llvm/Instructions.h"
 #include "llvm/Intrinsics.h"
 #include "llvm/Support/CFG.h"
 #include "llvm/Type.h"
+#include "llvm/CodeGen/FunctionLoweringInfo.h"
 #include "llvm/CodeGen/MachineConstantPool.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
@@ -30,12 +35,21 @@
 #include "llvm/CodeGen/SelectionDAGISel.h"
 #include "llvm/CodeGen/SelectionDAGNodes.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
+static cl::opt<bool> DisableConstantPool(
+  "disable-azpr-constant-pool",
+  cl::init(false),
+  cl::desc("Always materialize AZPR constants inline."),
+  cl::Hidden);
+
 //===----------------------------------------------------------------------===//
 // Instruction Selector Implementation
 //===----------------------------------------------------------------------===//
@@ -55,6 +69,9 @@ class AZPRDAGToDAGISel : public SelectionDAGISel {
   /// make the right decision when generating code for different targets.
   const AZPRSubtarget &Subtarget;
 
+  /// AnalyzeImm - Finds the cheapest sequence to materialize a constant.
+  AZPRAnalyzeImmediate AnalyzeImm;
+
 public:
   explicit AZPRDAGToDAGISel(AZPRTargetMachine &tm) :
   SelectionDAGISel(tm),
@@ -84,11 +101,35 @@ private:
 
   SDNode *Select(SDNode *N) /*override*/;
 
+  virtual void PreprocessISelDAG();
+
+  SDNode *SelectConstant(SDNode *N);
+  SDNode *SelectBRCOND(SDNode *N);
+  SDNode *SelectBitfieldAnd(SDNode *N);
+
+  void LoadConstantsFromPool(ArrayRef<SDNode*> Consts);
+  unsigned getConstantPoolBaseReg(const Constant *First);
+
   // Complex Pattern.
   bool SelectAddr(SDNode *Parent, SDValue N, SDValue &Base, SDValue &Offset);
 };
 }
 
+/// isOnlyUsedAsAddress - Return true if every user of N is a load or store
+/// that uses N only as its base pointer.
+static bool isOnlyUsedAsAddress(SDValue N) {
+  for (SDNode::use_iterator UI = N->use_begin(), UE = N->use_end();
+       UI != UE; ++UI) {
+    LSBaseSDNode *LS = dyn_cast<LSBaseSDNode>(*UI);
+    if (!LS || LS->getBasePtr() != N)
+      return false;
+    if (StoreSDNode *ST = dyn_cast<StoreSDNode>(LS))
+      if (ST->getValue() == N)
+        return false;
+  }
+  return true;
+}
+
 /// ComplexPattern used on AZPRInstrInfo
 /// Used on AZPR Load/Store instructions
 bool AZPRDAGToDAGISel::
@@ -116,26 +157,76 @@ SelectAddr(SDNode *Parent, SDValue N, SDValue &Base, SDValue &Offset) {
     return true;
   }
 
-  DEBUG(dbgs() << "SelectAddr: Unknown pattern?\n");
+  // グローバル変数のアドレス(AZPROr (AZPRHi sym), (AZPRLo sym))は, 上位を
+  // 補正したものをベースにして下位16bitをオフセットに入れる.
+  // アドレスそのものが他で必要なら全体を作った方が良いので何もしない.
+  if (LS && N.getOpcode() == AZPRISD::Or &&
+      N.getOperand(1).getOpcode() == AZPRISD::Lo &&
+      isOnlyUsedAsAddress(N)) {
+    if (GlobalAddressSDNode *GA =
+          dyn_cast<GlobalAddressSDNode>(N.getOperand(1).getOperand(0))) {
+      SDValue Sym = N.getOperand(1).getOperand(0);
+      Base = SDValue(CurDAG->getMachineNode(AZPR::LoadAddrHA, dl, ValTy, Sym),
+                     0);
+      Offset = CurDAG->getTargetGlobalAddress(GA->getGlobal(), dl, ValTy,
+                                              GA->getOffset(),
+                                              AZPRII::MO_ABS_LO);
+      return true;
+    }
+  }
+
+  // スモールコードモデル: アドレスは符号付き16bit(下位32KB)に収まるので,
+  // r0をベースにしてldw/stwのオフセットに直接入れる
+  if (LS && N.getOpcode() == AZPRISD::Abs16) {
+    Base = CurDAG->getRegister(AZPR::r0, ValTy);
+    Offset = N.getOperand(0);
+    return true;
+  }
+
+  // スモールデータ: (add gp, (AZPRGPRel sym))はgpをベースにする
+  if (N.getOpcode() == ISD::ADD &&
+      N.getOperand(1).getOpcode() == AZPRISD::GPRel) {
+    Base = N.getOperand(0);
+    Offset = N.getOperand(1).getOperand(0);
+    return true;
+  }
 
 /*
-Nが片方のOperandに定数を持つadd命令ならば、その定数をOffsetとし、もう一方をBaseとする
+Nが片方のOperandに定数を持つadd命令(または下位ビットが0と分かっているor命令)
+ならば、その定数をOffsetとし、もう一方をBaseとする
 */
-  SDNode *node = N.getNode();
-  if(node->getOpcode() == ISD::ADD){
-    ConstantSDNode *cn0 = dyn_cast<ConstantSDNode>(node->getOperand(0).getNode());
-    ConstantSDNode *cn1 = dyn_cast<ConstantSDNode>(node->getOperand(1).getNode());
-    if(cn0){
-      Base = node->getOperand(1);
-      Offset = CurDAG->getTargetConstant(cn0->getSExtValue(), ValTy);
+  if (CurDAG->isBaseWithConstantOffset(N)) {
+    int64_t Imm = cast<ConstantSDNode>(N.getOperand(1))->getSExtValue();
+    SDValue Addr = N.getOperand(0);
+
+    if (FrameIndexSDNode *FIN = dyn_cast<FrameIndexSDNode>(Addr)) {
+      // eliminateFrameIndexでフレーム内のオフセットが足されるので余裕をみる
+      if (isInt<15>(Imm)) {
+        Base   = CurDAG->getTargetFrameIndex(FIN->getIndex(), ValTy);
+        Offset = CurDAG->getTargetConstant(Imm, ValTy);
+        return true;
+      }
+    } else if (isInt<16>(Imm)) {
+      Base   = Addr;
+      Offset = CurDAG->getTargetConstant(Imm, ValTy);
       return true;
-    }
-    if(cn1){
-      Base = node->getOperand(0);
-      Offset = CurDAG->getTargetConstant(cn1->getSExtValue(), ValTy);
+    } else {
+      // 16bitに収まらない場合は上位をベースに足し, 下位を符号付きオフセットに
+      // する. 上位は下位16bitが0なので2命令で作れ, 同じ上位を持つアクセスの
+      // 間で共有される.
+      int64_t Lo = (int16_t)(Imm & 0xffff);
+      uint32_t Hi = (uint32_t)(Imm - Lo);
+      SDNode *HiNode =
+        CurDAG->getMachineNode(AZPR::LoadImm32, dl, ValTy,
+                               CurDAG->getTargetConstant(Hi, ValTy));
+      Base   = SDValue(CurDAG->getMachineNode(AZPR::ADDUR, dl, ValTy, Addr,
+                                              SDValue(HiNode, 0)), 0);
+      Offset = CurDAG->getTargetConstant(Lo, ValTy);
       return true;
     }
   }
+
+  DEBUG(dbgs() << "SelectAddr: Unknown pattern?\n");
   Base   = N;
   Offset = CurDAG->getTargetConstant(0, ValTy);
   return true;
@@ -144,11 +235,255 @@ Nが片方のOperandに定数を持つadd命令ならば、その定数をOffset
   return true;*/
 }
 
+/// isInConstantPool - Cが既にプールにあるか
+static bool isInConstantPool(const MachineConstantPool *MCP,
+                             const Constant *C) {
+  const std::vector<MachineConstantPoolEntry> &CPs = MCP->getConstants();
+  for (unsigned i = 0, e = CPs.size(); i != e; ++i)
+    if (!CPs[i].isMachineConstantPoolEntry() && CPs[i].Val.ConstVal == C)
+      return true;
+  return false;
+}
+
+namespace {
+struct ConstantValueLess {
+  bool operator()(SDNode *A, SDNode *B) const {
+    return cast<ConstantSDNode>(A)->getZExtValue() <
+           cast<ConstantSDNode>(B)->getZExtValue();
+  }
+};
+}
+
+/// PreprocessISelDAG - 複数命令が必要な定数のうち, 近い値(差が16bit以内)の
+/// 定数が他にあるものはそれにADDUIで差分を足して作る
+void AZPRDAGToDAGISel::PreprocessISelDAG() {
+  SmallVector<SDNode*, 16> Consts;
+
+  for (SelectionDAG::allnodes_iterator I = CurDAG->allnodes_begin(),
+       E = CurDAG->allnodes_end(); I != E; ++I) {
+    SDNode *N = &*I;
+    if (N->getOpcode() != ISD::Constant || N->use_empty() ||
+        N->getValueType(0) != MVT::i32)
+      continue;
+    if (AnalyzeImm.getCost(cast<ConstantSDNode>(N)->getZExtValue()) < 2)
+      continue;
+    Consts.push_back(N);
+  }
+
+  if (Consts.size() < 2)
+    return;
+
+  std::sort(Consts.begin(), Consts.end(), ConstantValueLess());
+
+  SDNode *Anchor = Consts[0];
+  for (unsigned i = 1, e = Consts.size(); i != e; ++i) {
+    SDNode *N = Consts[i];
+    int64_t Diff = (int64_t)cast<ConstantSDNode>(N)->getZExtValue() -
+                   (int64_t)cast<ConstantSDNode>(Anchor)->getZExtValue();
+    if (!isInt<16>(Diff)) {
+      Anchor = N;
+      continue;
+    }
+
+    DEBUG(dbgs() << "Derive constant: "; N->dump(CurDAG);
+          dbgs() << " from "; Anchor->dump(CurDAG); dbgs() << "\n");
+    // getNodeでADDを作ると定数畳み込みされるので直接ADDUIを作る
+    SDNode *Add = CurDAG->getMachineNode(AZPR::ADDUI, N->getDebugLoc(),
+                                         MVT::i32, SDValue(Anchor, 0),
+                                         CurDAG->getTargetConstant(Diff,
+                                                                   MVT::i32));
+    CurDAG->ReplaceAllUsesOfValueWith(SDValue(N, 0), SDValue(Add, 0));
+  }
+
+  if (DisableConstantPool)
+    return;
+
+  // 残った定数ごとに, その場で作る命令数とプールから読む語数(LDW 1命令と,
+  // プールにまだ無ければデータ1語)を比べる. 既に他のブロックでプールに
+  // 置いた値は何度読んでもデータが増えない.
+  MachineConstantPool *MCP = MF->getConstantPool();
+  SmallVector<SDNode*, 16> Pooled;
+  unsigned Saving = 0;
+  for (unsigned i = 0, e = Consts.size(); i != e; ++i) {
+    ConstantSDNode *CN = cast<ConstantSDNode>(Consts[i]);
+    if (CN->use_empty())
+      continue;
+    unsigned InlineCost = AnalyzeImm.getCost(CN->getZExtValue());
+    unsigned PoolCost = 1 + (isInConstantPool(MCP, CN->getConstantIntValue()) ?
+                             0 : 1);
+    if (InlineCost <= PoolCost)
+      continue;
+    Pooled.push_back(CN);
+    Saving += InlineCost - PoolCost;
+  }
+
+  // ベースアドレスは関数で1度だけ作る(3命令, スモールコードモデルなら
+  // 1命令). 既にあれば追加の命令はいらない.
+  AZPRMachineFunctionInfo *AFI = MF->getInfo<AZPRMachineFunctionInfo>();
+  unsigned BaseCost = 0;
+  if (!AFI->getConstantPoolBaseReg())
+    BaseCost = TM.getCodeModel() == CodeModel::Small ? 1 : 3;
+  if (!Pooled.empty() && Saving > BaseCost)
+    LoadConstantsFromPool(Pooled);
+}
+
+/// getConstantPoolBaseReg - プールのベースアドレスを持つ仮想レジスタを返す.
+/// 初めて呼ばれたときに入口のブロックで作る. LoadAddrは再実体化できるので
+/// 長い生存区間でもスピルにはならない.
+unsigned AZPRDAGToDAGISel::getConstantPoolBaseReg(const Constant *First) {
+  AZPRMachineFunctionInfo *AFI = MF->getInfo<AZPRMachineFunctionInfo>();
+  if (unsigned Reg = AFI->getConstantPoolBaseReg())
+    return Reg;
+
+  MachineConstantPool *MCP = MF->getConstantPool();
+  if (AFI->getConstantPoolBaseIndex() < 0)
+    AFI->setConstantPoolBaseIndex(MCP->getConstantPoolIndex(First, 4));
+
+  unsigned Reg =
+    MF->getRegInfo().createVirtualRegister(&AZPR::CPUGRegsRegClass);
+  MachineBasicBlock &Entry = MF->front();
+  unsigned Opc = TM.getCodeModel() == CodeModel::Small ?
+    AZPR::LoadAbs16 : AZPR::LoadAddr;
+  BuildMI(Entry, Entry.begin(), DebugLoc(), getInstrInfo()->get(Opc), Reg)
+    .addConstantPoolIndex(AFI->getConstantPoolBaseIndex());
+  AFI->setConstantPoolBaseReg(Reg);
+  return Reg;
+}
+
+/// LoadConstantsFromPool - Constsをコンスタントプールに置き,
+/// 関数ごとに決めたベースアドレスからのLDWで読む
+void AZPRDAGToDAGISel::LoadConstantsFromPool(ArrayRef<SDNode*> Consts) {
+  DebugLoc dl = Consts[0]->getDebugLoc();
+  unsigned BaseReg = getConstantPoolBaseReg(
+    cast<ConstantSDNode>(Consts[0])->getConstantIntValue());
+  SDValue Base = CurDAG->getCopyFromReg(CurDAG->getEntryNode(), dl, BaseReg,
+                                        MVT::i32);
+
+  MachineSDNode::mmo_iterator MemOp = MF->allocateMemRefsArray(1);
+  MemOp[0] = MF->getMachineMemOperand(MachinePointerInfo::getConstantPool(),
+                                      MachineMemOperand::MOLoad |
+                                      MachineMemOperand::MOInvariant, 4, 4);
+
+  for (unsigned i = 0, e = Consts.size(); i != e; ++i) {
+    SDNode *N = Consts[i];
+    const Constant *C = cast<ConstantSDNode>(N)->getConstantIntValue();
+    SDValue Offset = CurDAG->getTargetConstantPool(C, MVT::i32, 4, 0,
+                                                   AZPRII::MO_CPREL);
+    MachineSDNode *Ld =
+      CurDAG->getMachineNode(AZPR::LDW, N->getDebugLoc(), MVT::i32,
+                             MVT::Other, Base, Offset, CurDAG->getEntryNode());
+    Ld->setMemRefs(MemOp, MemOp + 1);
+    CurDAG->ReplaceAllUsesOfValueWith(SDValue(N, 0), SDValue(Ld, 0));
+  }
+}
+
+/// SelectConstant - 複数命令が必要な定数はLoadImm32にする.
+/// 命令列はRA後にAZPRAnalyzeImmediateで求めたものに展開される
+SDNode *AZPRDAGToDAGISel::SelectConstant(SDNode *Node) {
+  uint32_t Imm = cast<ConstantSDNode>(Node)->getZExtValue();
+
+  // 1命令で済むものは.tdのパターンに任せる
+  if (AnalyzeImm.getCost(Imm) < 2)
+    return NULL;
+
+  return CurDAG->getMachineNode(AZPR::LoadImm32, Node->getDebugLoc(),
+                                MVT::i32,
+                                CurDAG->getTargetConstant(Imm, MVT::i32));
+}
+
+/// SelectBRCOND - >=と<=の比較分岐命令はないので, 逆の条件で次のブロック
+/// (偽の場合の行き先)へ分岐してから無条件分岐する. 後ろにbrがある場合は
+/// AZPRTargetLoweringのDAG combineで条件を反転してあるのでここには来ない.
+/// 条件分岐とbe r0, r0の組はGetAnalyzableBrOpcがbsgt/bugtを知っているので
+/// AnalyzeBranchで解析できる.
+SDNode *AZPRDAGToDAGISel::SelectBRCOND(SDNode *Node) {
+  SDValue Cond = Node->getOperand(1);
+  if (Cond.getOpcode() != ISD::SETCC)
+    return NULL;
+
+  ISD::CondCode CC = cast<CondCodeSDNode>(Cond.getOperand(2))->get();
+  SDValue LHS = Cond.getOperand(0);
+  SDValue RHS = Cond.getOperand(1);
+  unsigned Opc;
+  switch (CC) {
+  // !(a >= b) = b > a
+  case ISD::SETGE:  Opc = AZPR::BSGT; break;
+  case ISD::SETUGE: Opc = AZPR::BUGT; break;
+  // !(a <= b) = a > b
+  case ISD::SETLE:  Opc = AZPR::BSGT; std::swap(LHS, RHS); break;
+  case ISD::SETULE: Opc = AZPR::BUGT; std::swap(LHS, RHS); break;
+  default:
+    return NULL;
+  }
+
+  MachineFunction::iterator Next = FuncInfo->MBB;
+  if (++Next == MF->end())
+    return NULL;
+
+  // BSGT/BUGT ra, rb は rb > ra で分岐する
+  DebugLoc dl = Node->getDebugLoc();
+  SDValue SkipOps[] = { LHS, RHS, CurDAG->getBasicBlock(Next),
+                        Node->getOperand(0) };
+  SDNode *Skip = CurDAG->getMachineNode(Opc, dl, MVT::Other, SkipOps, 4);
+
+  SDValue Zero = CurDAG->getRegister(AZPR::r0, MVT::i32);
+  SDValue Ops[] = { Zero, Zero, Node->getOperand(2), SDValue(Skip, 0) };
+  return CurDAG->SelectNodeTo(Node, AZPR::BE, MVT::Other, Ops, 4);
+}
+
+/// SelectBitfieldAnd - 16bitに収まらないマスクとのANDをシフト2つにする.
+/// マスク定数を作らずに済む.
+///   (and x, 2^w-1)            -> (x << (32-w)) >> (32-w)
+///   (and (srl x, s), 2^w-1)   -> (x << (32-s-w)) >> (32-w)
+///   (and x, ~(2^z-1))         -> (x >> z) << z
+SDNode *AZPRDAGToDAGISel::SelectBitfieldAnd(SDNode *Node) {
+  ConstantSDNode *MaskC = dyn_cast<ConstantSDNode>(Node->getOperand(1));
+  if (!MaskC || Node->getValueType(0) != MVT::i32)
+    return NULL;
+
+  // ANDI 1命令で済む
+  uint32_t Mask = MaskC->getZExtValue();
+  if (isUInt<16>(Mask))
+    return NULL;
+
+  DebugLoc dl = Node->getDebugLoc();
+  SDValue X = Node->getOperand(0);
+  if (isMask_32(Mask)) {
+    unsigned Width = CountTrailingOnes_32(Mask);
+    unsigned Shift = 0;
+    if (X.getOpcode() == ISD::SRL && X.hasOneUse())
+      if (ConstantSDNode *ShC = dyn_cast<ConstantSDNode>(X.getOperand(1)))
+        if (ShC->getZExtValue() + Width <= 32) {
+          Shift = ShC->getZExtValue();
+          X = X.getOperand(0);
+        }
+    SDNode *Shl = CurDAG->getMachineNode(AZPR::SHLLI, dl, MVT::i32, X,
+        CurDAG->getTargetConstant(32 - Shift - Width, MVT::i32));
+    return CurDAG->SelectNodeTo(Node, AZPR::SHRLI, MVT::i32, SDValue(Shl, 0),
+        CurDAG->getTargetConstant(32 - Width, MVT::i32));
+  }
+
+  if (isMask_32(~Mask)) {
+    unsigned Zeros = CountTrailingOnes_32(~Mask);
+    SDValue Amt = CurDAG->getTargetConstant(Zeros, MVT::i32);
+    SDNode *Shr = CurDAG->getMachineNode(AZPR::SHRLI, dl, MVT::i32, X, Amt);
+    return CurDAG->SelectNodeTo(Node, AZPR::SHLLI, MVT::i32,
+                                SDValue(Shr, 0), Amt);
+  }
+
+  return NULL;
+}
+
 /// Select instructions not customized! Used for
 /// expanded, promoted and normal instructions
 SDNode* AZPRDAGToDAGISel::
 Select(SDNode *Node) {
-//  DebugLoc dl = Node->getDebugLoc();
+  // PreprocessISelDAGで作った命令は選択済み
+  if (Node->isMachineOpcode()) {
+    Node->setNodeId(-1);
+    return NULL;
+  }
+
   switch(Node->getOpcode()) {
   case ISD::SELECT_CC: {
     ISD::CondCode CC = cast<CondCodeSDNode>(Node->getOperand(4))->get();
@@ -157,17 +492,18 @@ Select(SDNode *Node) {
                         CurDAG->getTargetConstant(CC, MVT::i32)};
     return CurDAG->SelectNodeTo(Node, AZPR::SELECT_CC, Node->getValueType(0), Ops, 5);
   }
-/*  case ISD::Constant:{
-    const ConstantSDNode *CN = dyn_cast<ConstantSDNode>(Node);
-    unsigned Size = CN->getValueSizeInBits(0);
-    int64_t Imm = CN->getSExtValue();
-    DEBUG(errs() << "Imm = " << Imm << ": Size = " << Size);
-    if((Imm & 0xFFFF0000) == 0){
-      SDValue ImmOpnd= CurDAG->getTargetConstant(Imm, MVT::i32);
-      return CurDAG->getMachineNode(AZPR::ORI, dl, MVT::i32, CurDAG->getRegister(AZPR::r0, MVT::i32), ImmOpnd);
-    }
-  }
-    break;*/
+  case ISD::BRCOND:
+    if (SDNode *Res = SelectBRCOND(Node))
+      return Res;
+    break;
+  case ISD::AND:
+    if (SDNode *Res = SelectBitfieldAnd(Node))
+      return Res;
+    break;
+  case ISD::Constant:
+    if (SDNode *Res = SelectConstant(Node))
+      return Res;
+    break;
   default:
     break;
   }
@@ -17,11 +17,15 @@
 #include "AZPRMachineFunction.h"
 #include "AZPRTargetMachine.h"
 #include "AZPRSubtarget.h"
+#include "AZPRTargetObjectFile.h"
 #include "InstPrinter/AZPRInstPrinter.h"
+#include "MCTargetDesc/AZPRBaseInfo.h"
 #include "MCTargetDesc/AZPRMCTargetDesc.h"
 #include "llvm/DerivedTypes.h"
 #include "llvm/Function.h"
 #include "llvm/GlobalVariable.h"
+#include "llvm/Instruction.h"
+#include "llvm/IntrinsicInst.h"
 #include "llvm/Intrinsics.h"
 #include "llvm/CallingConv.h"
 #include "llvm/CodeGen/CallingConvLower.h"
@@ -31,13 +35,33 @@
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/SelectionDAGISel.h"
 #include "llvm/CodeGen/ValueTypes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
-
-#include "llvm/CodeGen/TargetLoweringObjectFileImpl.h"
 using namespace llvm;
 
+static cl::opt<unsigned> SelectMaskThreshold(
+  "azpr-select-mask-threshold",
+  cl::init(10),
+  cl::desc("Maximum number of instructions for a branch-free select_cc."),
+  cl::Hidden);
+
+static cl::opt<bool> ExpensiveJumps(
+  "azpr-jump-is-expensive",
+  cl::init(false),
+  cl::desc("Evaluate && and || conditions as values instead of branch chains."),
+  cl::Hidden);
+
+static cl::opt<bool> TrapOverflow(
+  "azpr-trap-overflow",
+  cl::init(false),
+  cl::desc("Use the trapping addsr/subsr/addsi for signed overflow checks "
+           "that branch to llvm.trap (-ftrapv)."),
+  cl::Hidden);
+
 static std::string getFlagsString(const ISD::ArgFlagsTy &Flags) {
   if (Flags.isZExt()) {
     return "ZExt";
@@ -64,13 +88,17 @@ const char *AZPRTargetLowering::getTargetNodeName(unsigned Opcode) const {
   case AZPRISD::Hi:           return "AZPRISD::Hi";
   case AZPRISD::Lo:           return "AZPRISD::Lo";
   case AZPRISD::Or:           return "AZPRISD::Or";
+  case AZPRISD::GPRel:        return "AZPRISD::GPRel";
+  case AZPRISD::Abs16:        return "AZPRISD::Abs16";
+  case AZPRISD::AddTrap:      return "AZPRISD::AddTrap";
+  case AZPRISD::SubTrap:      return "AZPRISD::SubTrap";
   default:                    return NULL;
   }
 }
 
 AZPRTargetLowering::
 AZPRTargetLowering(AZPRTargetMachine &TM)
-  : TargetLowering(TM, new TargetLoweringObjectFileELF()),
+  : TargetLowering(TM, new AZPRTargetObjectFile()),
     Subtarget(*TM.getSubtargetImpl()) {
   DEBUG(dbgs() << ">> AZPRTargetLowering::constructor <<\n");
 
@@ -108,9 +136,70 @@ AZPRTargetLowering(AZPRTargetMachine &TM)
 //  setOperationAction(ISD::SELECT, MVT::i32, Expand);
 //  setOperationAction(ISD::SELECT_CC, MVT::Other, Expand);
   setOperationAction(ISD::GlobalAddress, MVT::i32, Custom);
+  setOperationAction(ISD::ConstantPool, MVT::i32, Custom);
+  // switchの密な部分はジャンプテーブル(ldwしてjmp)にする.
+  // 疎な部分はSelectionDAGBuilderが二分木とビットテストにし, それぞれ
+  // bsgt/bugt/be/bneとshllr, andr(andi), bneで比較分岐する.
+  setOperationAction(ISD::BR_JT, MVT::Other, Expand);
+  setOperationAction(ISD::JumpTable, MVT::i32, Custom);
   setOperationAction(ISD::LOAD, MVT::i8, Custom);
   setOperationAction(ISD::STORE, MVT::i8, Custom);
 //  setOperationAction(ISD::LOAD, MVT::i16, Custom);
+
+  // 乗除算命令はないのでライブラリ呼び出しにする
+  setOperationAction(ISD::MUL,       MVT::i32, Expand);
+  setOperationAction(ISD::MULHS,     MVT::i32, Expand);
+  setOperationAction(ISD::MULHU,     MVT::i32, Expand);
+  setOperationAction(ISD::SMUL_LOHI, MVT::i32, Expand);
+  setOperationAction(ISD::UMUL_LOHI, MVT::i32, Expand);
+  setOperationAction(ISD::SDIV,      MVT::i32, Expand);
+  setOperationAction(ISD::UDIV,      MVT::i32, Expand);
+  setOperationAction(ISD::SREM,      MVT::i32, Expand);
+  setOperationAction(ISD::UREM,      MVT::i32, Expand);
+  setOperationAction(ISD::SDIVREM,   MVT::i32, Expand);
+  setOperationAction(ISD::UDIVREM,   MVT::i32, Expand);
+
+  // 比較結果を値として使う場合は分岐せずに計算する
+  setOperationAction(ISD::SETCC, MVT::i32, Custom);
+  setOperationAction(ISD::SELECT_CC, MVT::i32, Custom);
+
+  // ビット数えはシフトとマスクで計算する. -Osではランタイム関数を呼ぶ
+  setOperationAction(ISD::CTPOP,           MVT::i32, Custom);
+  setOperationAction(ISD::CTLZ,            MVT::i32, Custom);
+  setOperationAction(ISD::CTLZ_ZERO_UNDEF, MVT::i32, Custom);
+  setOperationAction(ISD::CTTZ,            MVT::i32, Custom);
+  setOperationAction(ISD::CTTZ_ZERO_UNDEF, MVT::i32, Custom);
+
+  // 回転とバイト順の入れ替えはシフトとOR. CustomにしておくとDAGCombinerが
+  // 手書きの(x << n) | (x >> (32 - n))をROTL/ROTRにまとめる.
+  // 汎用のバイト入れ替えの認識(MatchBSwapHWord)はBSWAPがLegalでないと
+  // 働かないので, 手書きのバイト入れ替えはPerformBSwapCombineで見つける.
+  setOperationAction(ISD::ROTL,  MVT::i32, Custom);
+  setOperationAction(ISD::ROTR,  MVT::i32, Custom);
+  setOperationAction(ISD::BSWAP, MVT::i32, Custom);
+
+  // オーバーフロー付き加減算. 乗算はライブラリ呼び出しなので汎用の展開のまま
+  setOperationAction(ISD::UADDO, MVT::i32, Custom);
+  setOperationAction(ISD::SADDO, MVT::i32, Custom);
+  setOperationAction(ISD::USUBO, MVT::i32, Custom);
+  setOperationAction(ISD::SSUBO, MVT::i32, Custom);
+
+  // 不要な符号拡張を比較から取り除く
+  setTargetDAGCombine(ISD::SETCC);
+  // >=, <=の条件分岐を後ろのbrと入れ替えて>, <にする
+  setTargetDAGCombine(ISD::BR);
+
+  // && と || は分岐の連鎖にする. 比較分岐は1命令で, 遅延スロットも埋まる
+  // ことが多い. 一方, 値としての比較は<で6命令, 符号なし<で8命令かかる.
+  // 0との比較の組はSelectionDAGBuilderが (a|b)==0 のようにまとめる.
+  setJumpIsExpensive(ExpensiveJumps);
+  // 等価比較の組は1つの比較にまとめる
+  setTargetDAGCombine(ISD::AND);
+  setTargetDAGCombine(ISD::OR);
+  // 定数へのクランプ
+  setTargetDAGCombine(ISD::SELECT_CC);
+  // 16bitのバイト入れ替え (srl (bswap x), 16)
+  setTargetDAGCombine(ISD::SRL);
 }
 
 void
@@ -128,8 +217,24 @@ LowerOperation(SDValue Op, SelectionDAG &DAG) const {
   switch (Op.getOpcode())
   {
     case ISD::GlobalAddress:      return LowerGlobalAddress(Op, DAG);
+    case ISD::ConstantPool:       return LowerConstantPool(Op, DAG);
+    case ISD::JumpTable:          return LowerJumpTable(Op, DAG);
     case ISD::LOAD:               return LowerLOAD(Op, DAG);
     case ISD::STORE:              return LowerSTORE(Op, DAG);
+    case ISD::SETCC:              return LowerSETCC(Op, DAG);
+    case ISD::SELECT_CC:          return LowerSELECT_CC(Op, DAG);
+    case ISD::CTPOP:              return LowerCTPOP(Op, DAG);
+    case ISD::CTLZ:
+    case ISD::CTLZ_ZERO_UNDEF:    return LowerCTLZ(Op, DAG);
+    case ISD::CTTZ:
+    case ISD::CTTZ_ZERO_UNDEF:    return LowerCTTZ(Op, DAG);
+    case ISD::ROTL:
+    case ISD::ROTR:               return LowerRotate(Op, DAG);
+    case ISD::BSWAP:              return LowerBSWAP(Op, DAG);
+    case ISD::UADDO:
+    case ISD::SADDO:
+    case ISD::USUBO:
+    case ISD::SSUBO:              return LowerXALUO(Op, DAG);
   }
   llvm_unreachable("not supported operation");
   return SDValue();
@@ -141,17 +246,18 @@ static SDValue getTargetNode(SDValue Op, SelectionDAG &DAG) {
   EVT Ty = Op.getValueType();
 
   if (GlobalAddressSDNode *N = dyn_cast<GlobalAddressSDNode>(Op))
-    return DAG.getTargetGlobalAddress(N->getGlobal(), Op.getDebugLoc(), Ty, 0);
+    return DAG.getTargetGlobalAddress(N->getGlobal(), Op.getDebugLoc(), Ty,
+                                      N->getOffset());
+  if (ConstantPoolSDNode *N = dyn_cast<ConstantPoolSDNode>(Op))
+    return DAG.getTargetConstantPool(N->getConstVal(), Ty, N->getAlignment(),
+                                     N->getOffset(), 0);
+  if (JumpTableSDNode *N = dyn_cast<JumpTableSDNode>(Op))
+    return DAG.getTargetJumpTable(N->getIndex(), Ty);
 /*
   if (ExternalSymbolSDNode *N = dyn_cast<ExternalSymbolSDNode>(Op))
     return DAG.getTargetExternalSymbol(N->getSymbol(), Ty, Flag);
   if (BlockAddressSDNode *N = dyn_cast<BlockAddressSDNode>(Op))
     return DAG.getTargetBlockAddress(N->getBlockAddress(), Ty, 0, Flag);
-  if (JumpTableSDNode *N = dyn_cast<JumpTableSDNode>(Op))
-    return DAG.getTargetJumpTable(N->getIndex(), Ty, Flag);
-  if (ConstantPoolSDNode *N = dyn_cast<ConstantPoolSDNode>(Op))
-    return DAG.getTargetConstantPool(N->getConstVal(), Ty, N->getAlignment(),
-                                     N->getOffset(), Flag);
 */
   llvm_unreachable("Unexpected node type.");
   return SDValue();
@@ -160,6 +266,12 @@ static SDValue getTargetNode(SDValue Op, SelectionDAG &DAG) {
 static SDValue getAddrNonPIC(SDValue Op, SelectionDAG &DAG) {
   DebugLoc DL = Op.getDebugLoc();
   EVT Ty = Op.getValueType();
+
+  // スモールコードモデルではシンボルは符号付き16bitの範囲(下位32KB)に
+  // あるのでaddui 1命令
+  if (DAG.getTarget().getCodeModel() == CodeModel::Small)
+    return DAG.getNode(AZPRISD::Abs16, DL, Ty, getTargetNode(Op, DAG));
+
   SDValue Hi = DAG.getNode(AZPRISD::Hi, DL, Ty, getTargetNode(Op, DAG));
   SDValue Lo = DAG.getNode(AZPRISD::Lo, DL, Ty, getTargetNode(Op, DAG));
 
@@ -173,18 +285,18 @@ SDValue AZPRTargetLowering::LowerGlobalAddress(SDValue Op,
   const GlobalValue *GV = cast<GlobalAddressSDNode>(Op)->getGlobal();
 
   if (getTargetMachine().getRelocationModel() != Reloc::PIC_) {
-/*    const MipsTargetObjectFile &TLOF =
-      (const MipsTargetObjectFile&)getObjFileLowering();
+    const AZPRTargetObjectFile &TLOF =
+      (const AZPRTargetObjectFile&)getObjFileLowering();
 
     // %gp_rel relocation
     if (TLOF.IsGlobalInSmallSection(GV, getTargetMachine())) {
-      SDValue GA = DAG.getTargetGlobalAddress(GV, dl, MVT::i32, 0,
-                                              MipsII::MO_GPREL);
-      SDValue GPRelNode = DAG.getNode(MipsISD::GPRel, dl,
-                                      DAG.getVTList(MVT::i32), &GA, 1);
-      SDValue GPReg = DAG.getRegister(Mips::GP, MVT::i32);
+      SDValue GA = DAG.getTargetGlobalAddress(GV, dl, MVT::i32,
+                         cast<GlobalAddressSDNode>(Op)->getOffset(),
+                         AZPRII::MO_GPREL);
+      SDValue GPRelNode = DAG.getNode(AZPRISD::GPRel, dl, MVT::i32, GA);
+      SDValue GPReg = DAG.getRegister(AZPR::r28, MVT::i32);
       return DAG.getNode(ISD::ADD, dl, MVT::i32, GPReg, GPRelNode);
-    }*/
+    }
 
     // %hi/%lo relocation
 /*    const GlobalVariable *GVA = dyn_cast<GlobalVariable>(GV);
@@ -221,22 +333,40 @@ SDValue AZPRTargetLowering::LowerGlobalAddress(SDValue Op,
                        HasMips64 ? MipsII::MO_GOT_DISP : MipsII::MO_GOT16);*/
 }
 
+SDValue AZPRTargetLowering::LowerConstantPool(SDValue Op,
+                                              SelectionDAG &DAG) const {
+  return getAddrNonPIC(Op, DAG);
+}
+
+SDValue AZPRTargetLowering::LowerJumpTable(SDValue Op,
+                                           SelectionDAG &DAG) const {
+  return getAddrNonPIC(Op, DAG);
+}
+
 //XCoreのを参照
 SDValue AZPRTargetLowering::LowerLOAD(SDValue Op, SelectionDAG &DAG) const {
   LoadSDNode *LD = cast<LoadSDNode>(Op.getNode());
   DebugLoc dl = Op.getDebugLoc();
   EVT SrcVT = LD->getMemoryVT();
   if(SrcVT == MVT::i8){//細かい条件は考えない
+    bool isSExt = LD->getExtensionType() == ISD::SEXTLOAD;
     SDValue tmp1 = DAG.getNode(ISD::AND, dl, MVT::i32, LD->getBasePtr(), DAG.getConstant(3, MVT::i32));
     tmp1 = DAG.getNode(ISD::SHL, dl, MVT::i32, tmp1, DAG.getConstant(3, MVT::i32));
-    tmp1 = DAG.getNode(ISD::SUB, dl, MVT::i32, DAG.getConstant(24, MVT::i32), tmp1);
+    //符号拡張する場合は上位に詰めてから算術右シフトする
+    if(!isSExt)
+      tmp1 = DAG.getNode(ISD::SUB, dl, MVT::i32, DAG.getConstant(24, MVT::i32), tmp1);
     SDValue tmp2 = DAG.getNode(ISD::AND, dl, MVT::i32, LD->getBasePtr(), DAG.getConstant(~3, MVT::i32));
 //    return tmp2 = DAG.getLoad(LD->getAddressingMode(), ISD::NON_EXTLOAD /*LD->getExtensionType()*/, MVT::i32, dl,
 //			LD->getChain(), tmp2, LD->getOffset(), MVT::i32, LD->getMemOperand());
     tmp2 = DAG.getLoad(getPointerTy(), dl, LD->getChain(),
                                tmp2, MachinePointerInfo(),
                                false, false, false, 0);
-    tmp1 = DAG.getNode(ISD::SRL, dl, MVT::i32, tmp2, tmp1);
+    if(isSExt){
+      tmp1 = DAG.getNode(ISD::SHL, dl, MVT::i32, tmp2, tmp1);
+      tmp1 = DAG.getNode(ISD::SRA, dl, MVT::i32, tmp1, DAG.getConstant(24, MVT::i32));
+    }
+    else
+      tmp1 = DAG.getNode(ISD::SRL, dl, MVT::i32, tmp2, tmp1);
     tmp1 = DAG.getZExtOrTrunc(tmp1, dl, LD->getValueType(0)/*MVT::i8*/);//i8にtrunc, i8でいいのか?getValueTypeするべきか?
 //    tmp1 = DAG.getNode(ISD::AND, dl, MVT::i32, tmp1, DAG.getConstant(0xFF, MVT::i32));
     SDValue Chain = DAG.getNode(ISD::TokenFactor, dl, MVT::Other, tmp2.getValue(1));
@@ -281,6 +411,863 @@ SDValue AZPRTargetLowering::LowerSTORE(SDValue Op, SelectionDAG &DAG) const {
 
 }
 
+/// getSetCCValue - LHS CC RHSの結果(0か1)を分岐なしで計算する.
+/// 扱えない条件ならSDValue()を返す.
+static SDValue getSetCCValue(SelectionDAG &DAG, DebugLoc dl,
+                             SDValue LHS, SDValue RHS, ISD::CondCode CC) {
+  EVT VT = MVT::i32;
+  SDValue Zero = DAG.getConstant(0, VT);
+  SDValue One = DAG.getConstant(1, VT);
+  SDValue SignShift = DAG.getConstant(31, VT);
+  bool Invert = false;
+
+  switch (CC) {
+  case ISD::SETEQ:
+  case ISD::SETNE: {
+    // x != 0 <=> (x | -x)の符号ビットが立つ
+    SDValue X = LHS;
+    if (!isa<ConstantSDNode>(RHS) || !cast<ConstantSDNode>(RHS)->isNullValue())
+      X = DAG.getNode(ISD::XOR, dl, VT, LHS, RHS);
+    SDValue Neg = DAG.getNode(ISD::SUB, dl, VT, Zero, X);
+    SDValue Bit = DAG.getNode(ISD::SRL, dl, VT,
+                              DAG.getNode(ISD::OR, dl, VT, X, Neg), SignShift);
+    return CC == ISD::SETEQ ? DAG.getNode(ISD::XOR, dl, VT, Bit, One) : Bit;
+  }
+  // a > b -> b < a
+  case ISD::SETGT:  std::swap(LHS, RHS); CC = ISD::SETLT;  break;
+  case ISD::SETUGT: std::swap(LHS, RHS); CC = ISD::SETULT; break;
+  // a >= b -> !(a < b)
+  case ISD::SETGE:  Invert = true; CC = ISD::SETLT;  break;
+  case ISD::SETUGE: Invert = true; CC = ISD::SETULT; break;
+  // a <= b -> !(b < a)
+  case ISD::SETLE:
+    std::swap(LHS, RHS); Invert = true; CC = ISD::SETLT;  break;
+  case ISD::SETULE:
+    std::swap(LHS, RHS); Invert = true; CC = ISD::SETULT; break;
+  case ISD::SETLT:
+  case ISD::SETULT:
+    break;
+  default:
+    return SDValue();
+  }
+
+  SDValue Diff = DAG.getNode(ISD::SUB, dl, VT, LHS, RHS);
+  SDValue Sign;
+  if (CC == ISD::SETLT) {
+    if (isa<ConstantSDNode>(RHS) && cast<ConstantSDNode>(RHS)->isNullValue())
+      Sign = LHS;
+    else {
+      // a - bがオーバーフローしたときは符号を反転する (Hacker's Delight 2-12)
+      // (a - b) ^ ((a ^ b) & ((a - b) ^ a))
+      SDValue Ovf = DAG.getNode(ISD::AND, dl, VT,
+                                DAG.getNode(ISD::XOR, dl, VT, LHS, RHS),
+                                DAG.getNode(ISD::XOR, dl, VT, Diff, LHS));
+      Sign = DAG.getNode(ISD::XOR, dl, VT, Diff, Ovf);
+    }
+  } else {
+    // 借りが出るか: (~a & b) | (~(a ^ b) & (a - b))
+    SDValue NotA = DAG.getNOT(dl, LHS, VT);
+    SDValue Eq = DAG.getNOT(dl, DAG.getNode(ISD::XOR, dl, VT, LHS, RHS), VT);
+    Sign = DAG.getNode(ISD::OR, dl, VT,
+                       DAG.getNode(ISD::AND, dl, VT, NotA, RHS),
+                       DAG.getNode(ISD::AND, dl, VT, Eq, Diff));
+  }
+
+  SDValue Bit = DAG.getNode(ISD::SRL, dl, VT, Sign, SignShift);
+  return Invert ? DAG.getNode(ISD::XOR, dl, VT, Bit, One) : Bit;
+}
+
+SDValue AZPRTargetLowering::LowerSETCC(SDValue Op, SelectionDAG &DAG) const {
+  // 分岐の条件にしか使われないならBrCondのパターンで比較分岐命令になる
+  bool OnlyBranches = true;
+  for (SDNode::use_iterator UI = Op->use_begin(), UE = Op->use_end();
+       UI != UE; ++UI)
+    if (UI->getOpcode() != ISD::BRCOND) {
+      OnlyBranches = false;
+      break;
+    }
+  if (OnlyBranches)
+    return SDValue();
+
+  ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(2))->get();
+  return getSetCCValue(DAG, Op.getDebugLoc(), Op.getOperand(0),
+                       Op.getOperand(1), CC);
+}
+
+/// getSetCCCost - getSetCCValueが作る命令数
+static unsigned getSetCCCost(SDValue RHS, ISD::CondCode CC) {
+  bool RHSZero = isa<ConstantSDNode>(RHS) &&
+                 cast<ConstantSDNode>(RHS)->isNullValue();
+  switch (CC) {
+  case ISD::SETNE:  return RHSZero ? 3 : 4;
+  case ISD::SETEQ:  return RHSZero ? 4 : 5;
+  case ISD::SETLT:  return RHSZero ? 1 : 6;
+  case ISD::SETGE:  return RHSZero ? 2 : 7;
+  case ISD::SETGT:  return 6;
+  case ISD::SETLE:  return 7;
+  case ISD::SETULT:
+  case ISD::SETUGT: return 8;
+  default:          return 9;
+  }
+}
+
+/// LowerSELECT_CC - (select_cc a, b, 1, 0, cc)はDAGCombinerがzext(setcc)から
+/// 作るので, setccと同じく分岐なしで計算する. それ以外でも比較が安ければ
+/// 0/-1のマスクで f ^ ((t ^ f) & mask) として選ぶ. 高くつくときは
+/// SELECT_CC擬似命令(分岐)にする.
+SDValue AZPRTargetLowering::LowerSELECT_CC(SDValue Op,
+                                           SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  EVT VT = Op.getValueType();
+  SDValue LHS = Op.getOperand(0);
+  SDValue RHS = Op.getOperand(1);
+  SDValue TrueV = Op.getOperand(2);
+  SDValue FalseV = Op.getOperand(3);
+  ISD::CondCode CC = cast<CondCodeSDNode>(Op.getOperand(4))->get();
+  ConstantSDNode *TrueC = dyn_cast<ConstantSDNode>(TrueV);
+  ConstantSDNode *FalseC = dyn_cast<ConstantSDNode>(FalseV);
+
+  if (TrueC && FalseC) {
+    if (TrueC->isOne() && FalseC->isNullValue())
+      return getSetCCValue(DAG, dl, LHS, RHS, CC);
+    if (TrueC->isNullValue() && FalseC->isOne())
+      return getSetCCValue(DAG, dl, LHS, RHS,
+                           ISD::getSetCCInverse(CC, true));
+  }
+
+  // 両方の値は分岐の前に計算済みなので, 比較とマスクの命令数だけを見る.
+  // 分岐にすると比較分岐, 遅延スロット, コピーが要る.
+  // 符号付きか0との比較のmin/maxは分岐にしても片側でコピーが要り, 分岐先が
+  // データで変わるのでしきい値によらずマスクで選ぶ. 符号なしの比較は
+  // 8命令かかるので他のselectと同じく命令数で決める.
+  bool TrueZero = TrueC && TrueC->isNullValue();
+  bool FalseZero = FalseC && FalseC->isNullValue();
+  bool RHSZero = isa<ConstantSDNode>(RHS) &&
+                 cast<ConstantSDNode>(RHS)->isNullValue();
+  bool IsMinMax = ((TrueV == LHS && FalseV == RHS) ||
+                   (TrueV == RHS && FalseV == LHS)) &&
+                  (ISD::isSignedIntSetCC(CC) || RHSZero);
+  unsigned Cost = getSetCCCost(RHS, CC) + (TrueZero || FalseZero ? 2 : 4);
+  if (!IsMinMax && Cost > SelectMaskThreshold)
+    return SDValue();
+
+  SDValue Bit = getSetCCValue(DAG, dl, LHS, RHS, CC);
+  if (!Bit.getNode())
+    return SDValue();
+
+  // c ? t : 0 -> t & -c
+  // c ? 0 : f -> f & (c - 1)
+  SDValue Zero = DAG.getConstant(0, VT);
+  if (FalseZero)
+    return DAG.getNode(ISD::AND, dl, VT, TrueV,
+                       DAG.getNode(ISD::SUB, dl, VT, Zero, Bit));
+  if (TrueZero)
+    return DAG.getNode(ISD::AND, dl, VT, FalseV,
+                       DAG.getNode(ISD::ADD, dl, VT, Bit,
+                                   DAG.getConstant(-1, VT)));
+
+  SDValue Mask = DAG.getNode(ISD::SUB, dl, VT, Zero, Bit);
+  SDValue Diff = DAG.getNode(ISD::XOR, dl, VT, TrueV, FalseV);
+  return DAG.getNode(ISD::XOR, dl, VT, FalseV,
+                     DAG.getNode(ISD::AND, dl, VT, Diff, Mask));
+}
+
+/// optimizeForSize - 関数が-Os(optsize)でコンパイルされているか
+static bool optimizeForSize(SelectionDAG &DAG) {
+  return DAG.getMachineFunction().getFunction()->getFnAttributes().
+    hasAttribute(Attributes::OptimizeForSize);
+}
+
+/// getLibCall - i32を1つ受け取ってi32を返すランタイム関数を呼ぶ
+static SDValue getLibCall(const TargetLowering &TLI, SelectionDAG &DAG,
+                          const char *Name, SDValue Arg, DebugLoc dl) {
+  Type *Int32Ty = Type::getInt32Ty(*DAG.getContext());
+  TargetLowering::ArgListTy Args;
+  TargetLowering::ArgListEntry Entry;
+  Entry.Node = Arg;
+  Entry.Ty = Int32Ty;
+  Args.push_back(Entry);
+
+  SDValue Callee = DAG.getExternalSymbol(Name, TLI.getPointerTy());
+  TargetLowering::
+  CallLoweringInfo CLI(DAG.getEntryNode(), Int32Ty, false, false, false, false,
+                       0, CallingConv::C, /*isTailCall=*/false,
+                       /*doesNotReturn=*/false, /*isReturnValueUsed=*/true,
+                       Callee, Args, DAG, dl);
+  return TLI.LowerCallTo(CLI).first;
+}
+
+/// getPopCount - SWARでビット数を数える. 最後の足し込みは乗算の代わりに
+/// シフトと加算で行う. マスクはLoadImm32でループの外に出る.
+static SDValue getPopCount(SelectionDAG &DAG, DebugLoc dl, SDValue X) {
+  EVT VT = MVT::i32;
+  SDValue M1 = DAG.getConstant(0x55555555, VT);
+  SDValue M2 = DAG.getConstant(0x33333333, VT);
+  SDValue M4 = DAG.getConstant(0x0F0F0F0F, VT);
+
+  // x - ((x >> 1) & 0x55555555): 2bitごとの個数
+  SDValue T = DAG.getNode(ISD::AND, dl, VT,
+                          DAG.getNode(ISD::SRL, dl, VT, X,
+                                      DAG.getConstant(1, VT)), M1);
+  X = DAG.getNode(ISD::SUB, dl, VT, X, T);
+  // 4bitごと
+  T = DAG.getNode(ISD::AND, dl, VT,
+                  DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(2, VT)), M2);
+  X = DAG.getNode(ISD::ADD, dl, VT, DAG.getNode(ISD::AND, dl, VT, X, M2), T);
+  // 8bitごと
+  X = DAG.getNode(ISD::ADD, dl, VT, X,
+                  DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(4, VT)));
+  X = DAG.getNode(ISD::AND, dl, VT, X, M4);
+  // 4バイトを足し込む. 最大32なので下位6bitを取る
+  X = DAG.getNode(ISD::ADD, dl, VT, X,
+                  DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(8, VT)));
+  X = DAG.getNode(ISD::ADD, dl, VT, X,
+                  DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(16, VT)));
+  return DAG.getNode(ISD::AND, dl, VT, X, DAG.getConstant(0x3F, VT));
+}
+
+/// getLeadingZeros - 分岐なしの二分探索で先頭の0を数える.
+/// 定数はすべて16bitに収まる (Hacker's Delight 5-3). x = 0なら32.
+static SDValue getLeadingZeros(SelectionDAG &DAG, DebugLoc dl, SDValue X) {
+  EVT VT = MVT::i32;
+  SDValue Sixteen = DAG.getConstant(16, VT);
+
+  // 上位16bitが0ならn = 16, そうでなければxを16bit右にずらしてn = 0
+  SDValue Y = DAG.getNode(ISD::SUB, dl, VT, DAG.getConstant(0, VT),
+                          DAG.getNode(ISD::SRL, dl, VT, X, Sixteen));
+  SDValue M = DAG.getNode(ISD::AND, dl, VT,
+                          DAG.getNode(ISD::SRL, dl, VT, Y, Sixteen), Sixteen);
+  SDValue N = DAG.getNode(ISD::SUB, dl, VT, Sixteen, M);
+  X = DAG.getNode(ISD::SRL, dl, VT, X, M);
+
+  // xは16bit以下. 上位8, 4, 2bitが0ならnに足してxを左にずらす
+  static const struct { unsigned Sub, Bits; } Steps[] = {
+    { 0x100, 8 }, { 0x1000, 4 }, { 0x4000, 2 }
+  };
+  for (unsigned i = 0; i != array_lengthof(Steps); ++i) {
+    Y = DAG.getNode(ISD::ADD, dl, VT, X,
+                    DAG.getConstant(-(int)Steps[i].Sub, VT));
+    M = DAG.getNode(ISD::AND, dl, VT,
+                    DAG.getNode(ISD::SRL, dl, VT, Y, Sixteen),
+                    DAG.getConstant(Steps[i].Bits, VT));
+    N = DAG.getNode(ISD::ADD, dl, VT, N, M);
+    X = DAG.getNode(ISD::SHL, dl, VT, X, M);
+  }
+
+  // 残りの2bit y = 0..3 に対して 0, 1, 2, 2 を引く
+  Y = DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(14, VT));
+  M = DAG.getNode(ISD::XOR, dl, VT, Y,
+                  DAG.getNode(ISD::AND, dl, VT, Y,
+                              DAG.getNode(ISD::SRL, dl, VT, Y,
+                                          DAG.getConstant(1, VT))));
+  N = DAG.getNode(ISD::ADD, dl, VT, N, DAG.getConstant(2, VT));
+  return DAG.getNode(ISD::SUB, dl, VT, N, M);
+}
+
+SDValue AZPRTargetLowering::LowerCTPOP(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  if (optimizeForSize(DAG))
+    return getLibCall(*this, DAG, "__popcountsi2", Op.getOperand(0), dl);
+  return getPopCount(DAG, dl, Op.getOperand(0));
+}
+
+SDValue AZPRTargetLowering::LowerCTLZ(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  // __clzsi2(0)は未定義
+  if (Op.getOpcode() == ISD::CTLZ_ZERO_UNDEF && optimizeForSize(DAG))
+    return getLibCall(*this, DAG, "__clzsi2", Op.getOperand(0), dl);
+  return getLeadingZeros(DAG, dl, Op.getOperand(0));
+}
+
+/// LowerCTTZ - 最下位の1より下を1にしたマスク (x & -x) - 1 の先頭の0から
+/// 求める: cttz(x) = 32 - ctlz((x & -x) - 1). x = 0なら32.
+SDValue AZPRTargetLowering::LowerCTTZ(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  EVT VT = Op.getValueType();
+  SDValue X = Op.getOperand(0);
+  SDValue Lowest = DAG.getNode(ISD::AND, dl, VT, X,
+                               DAG.getNode(ISD::SUB, dl, VT,
+                                           DAG.getConstant(0, VT), X));
+  SDValue Below = DAG.getNode(ISD::ADD, dl, VT, Lowest,
+                              DAG.getConstant(-1, VT));
+
+  // -Osではマスクの1を数える
+  if (optimizeForSize(DAG))
+    return getLibCall(*this, DAG, "__popcountsi2", Below, dl);
+
+  return DAG.getNode(ISD::SUB, dl, VT, DAG.getConstant(32, VT),
+                     getLeadingZeros(DAG, dl, Below));
+}
+
+/// LowerRotate - rotl(x, n) = (x << n) | (x >> (32 - n)).
+/// nが変数のときは32 - nの代わりに-n & 31を使う. n = 0でも32ビットの
+/// シフトにならず, 同じnのrotl/rotrでは共有される.
+SDValue AZPRTargetLowering::LowerRotate(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  EVT VT = Op.getValueType();
+  SDValue X = Op.getOperand(0);
+  SDValue N = Op.getOperand(1);
+
+  SDValue Other;
+  if (ConstantSDNode *C = dyn_cast<ConstantSDNode>(N)) {
+    unsigned Amt = C->getZExtValue() & 31;
+    if (Amt == 0)
+      return X;
+    N = DAG.getConstant(Amt, VT);
+    Other = DAG.getConstant(32 - Amt, VT);
+  } else
+    Other = DAG.getNode(ISD::AND, dl, VT,
+                        DAG.getNode(ISD::SUB, dl, VT,
+                                    DAG.getConstant(0, VT), N),
+                        DAG.getConstant(31, VT));
+
+  unsigned Fwd = Op.getOpcode() == ISD::ROTL ? ISD::SHL : ISD::SRL;
+  unsigned Back = Op.getOpcode() == ISD::ROTL ? ISD::SRL : ISD::SHL;
+  return DAG.getNode(ISD::OR, dl, VT,
+                     DAG.getNode(Fwd, dl, VT, X, N),
+                     DAG.getNode(Back, dl, VT, X, Other));
+}
+
+/// LowerBSWAP - マスクがすべて16bitに収まる形でバイトを入れ替える
+///   (x << 24) | ((x & 0xff00) << 8) | ((x >> 8) & 0xff00) | (x >> 24)
+SDValue AZPRTargetLowering::LowerBSWAP(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  EVT VT = Op.getValueType();
+  SDValue X = Op.getOperand(0);
+  SDValue Eight = DAG.getConstant(8, VT);
+  SDValue TwentyFour = DAG.getConstant(24, VT);
+  SDValue ByteMask = DAG.getConstant(0xff00, VT);
+
+  SDValue B3 = DAG.getNode(ISD::SHL, dl, VT, X, TwentyFour);
+  SDValue B2 = DAG.getNode(ISD::SHL, dl, VT,
+                           DAG.getNode(ISD::AND, dl, VT, X, ByteMask), Eight);
+  SDValue B1 = DAG.getNode(ISD::AND, dl, VT,
+                           DAG.getNode(ISD::SRL, dl, VT, X, Eight), ByteMask);
+  SDValue B0 = DAG.getNode(ISD::SRL, dl, VT, X, TwentyFour);
+  return DAG.getNode(ISD::OR, dl, VT,
+                     DAG.getNode(ISD::OR, dl, VT, B3, B2),
+                     DAG.getNode(ISD::OR, dl, VT, B1, B0));
+}
+
+/// isTrapBlock - llvm.trapから始まるブロックか
+static bool isTrapBlock(SDValue Dest) {
+  BasicBlockSDNode *BBN = dyn_cast<BasicBlockSDNode>(Dest);
+  if (!BBN)
+    return false;
+  const BasicBlock *BB = BBN->getBasicBlock()->getBasicBlock();
+  if (!BB)
+    return false;
+  const IntrinsicInst *II = dyn_cast<IntrinsicInst>(BB->getFirstNonPHIOrDbg());
+  return II && II->getIntrinsicID() == Intrinsic::trap;
+}
+
+/// LowerXALUO - オーバーフロー付き加減算. フラグは符号ビットが立った語との
+/// (setlt w, 0)にする. 分岐だけに使われるならbsgt w, r0, 値ならshrli 31になる.
+/// 符号なしで分岐だけに使われる場合はbugt 1命令で比べる.
+SDValue AZPRTargetLowering::LowerXALUO(SDValue Op, SelectionDAG &DAG) const {
+  DebugLoc dl = Op.getDebugLoc();
+  EVT VT = Op.getValueType();
+  EVT OvfVT = Op->getValueType(1);
+  SDValue A = Op.getOperand(0);
+  SDValue B = Op.getOperand(1);
+  SDValue Zero = DAG.getConstant(0, VT);
+  unsigned Opc = Op.getOpcode();
+  bool IsAdd = Opc == ISD::UADDO || Opc == ISD::SADDO;
+
+  bool OnlyBranches = true;
+  unsigned NumFlagUses = 0;
+  SDNode *TrapBr = 0;
+  for (SDNode::use_iterator UI = Op->use_begin(), UE = Op->use_end();
+       UI != UE; ++UI) {
+    if (UI.getUse().getResNo() != 1)
+      continue;
+    ++NumFlagUses;
+    if (UI->getOpcode() != ISD::BRCOND)
+      OnlyBranches = false;
+    else if (isTrapBlock(UI->getOperand(2)))
+      TrapBr = *UI;
+  }
+
+  // -ftrapvの検査はハードウェアの例外に任せる. 例外が元の分岐の位置で
+  // 起きるように分岐のチェーンの間に入れる. 和を使わなくても消えない.
+  // フラグは常に0なのでtrapへの分岐は消える.
+  if (TrapOverflow && TrapBr && NumFlagUses == 1 &&
+      (Opc == ISD::SADDO || Opc == ISD::SSUBO)) {
+    SDValue Trap = DAG.getNode(IsAdd ? AZPRISD::AddTrap : AZPRISD::SubTrap,
+                               dl, DAG.getVTList(VT, MVT::Other),
+                               TrapBr->getOperand(0), A, B);
+    DAG.UpdateNodeOperands(TrapBr, Trap.getValue(1), TrapBr->getOperand(1),
+                           TrapBr->getOperand(2));
+    SDValue Ops[] = { Trap, DAG.getConstant(0, OvfVT) };
+    return DAG.getMergeValues(Ops, 2, dl);
+  }
+
+  SDValue Res = DAG.getNode(IsAdd ? ISD::ADD : ISD::SUB, dl, VT, A, B);
+
+  SDValue Word;
+  switch (Opc) {
+  default: llvm_unreachable("unexpected opcode");
+  case ISD::SADDO:
+    // 和の符号がa, bの両方と違う: (s ^ a) & (s ^ b)
+    Word = DAG.getNode(ISD::AND, dl, VT,
+                       DAG.getNode(ISD::XOR, dl, VT, Res, A),
+                       DAG.getNode(ISD::XOR, dl, VT, Res, B));
+    break;
+  case ISD::SSUBO:
+    // a, bの符号が違い, 差の符号がaと違う: (a ^ b) & (a ^ d)
+    Word = DAG.getNode(ISD::AND, dl, VT,
+                       DAG.getNode(ISD::XOR, dl, VT, A, B),
+                       DAG.getNode(ISD::XOR, dl, VT, A, Res));
+    break;
+  case ISD::UADDO: {
+    if (OnlyBranches)
+      break;
+    // 桁上がり: (a & b) | ((a | b) & ~s). ~sの代わりに t ^ (t & s)
+    SDValue T = DAG.getNode(ISD::OR, dl, VT, A, B);
+    Word = DAG.getNode(ISD::OR, dl, VT,
+                       DAG.getNode(ISD::AND, dl, VT, A, B),
+                       DAG.getNode(ISD::XOR, dl, VT, T,
+                                   DAG.getNode(ISD::AND, dl, VT, T, Res)));
+    break;
+  }
+  case ISD::USUBO: {
+    if (OnlyBranches)
+      break;
+    // 借り: (~a & b) | (~(a ^ b) & d)
+    SDValue X = DAG.getNode(ISD::XOR, dl, VT, A, B);
+    Word = DAG.getNode(ISD::OR, dl, VT,
+                       DAG.getNode(ISD::XOR, dl, VT, B,
+                                   DAG.getNode(ISD::AND, dl, VT, A, B)),
+                       DAG.getNode(ISD::XOR, dl, VT, Res,
+                                   DAG.getNode(ISD::AND, dl, VT, X, Res)));
+    break;
+  }
+  }
+
+  SDValue Ovf;
+  if (Word.getNode())
+    Ovf = DAG.getSetCC(dl, OvfVT, Word, Zero, ISD::SETLT);
+  else if (Opc == ISD::UADDO)
+    Ovf = DAG.getSetCC(dl, OvfVT, Res, A, ISD::SETULT);
+  else
+    Ovf = DAG.getSetCC(dl, OvfVT, A, B, ISD::SETULT);
+
+  SDValue Ops[] = { Res, Ovf };
+  return DAG.getMergeValues(Ops, 2, dl);
+}
+
+//===----------------------------------------------------------------------===//
+//                          DAG Combine
+//===----------------------------------------------------------------------===//
+
+// (setcc (sext_inreg x, VT), y) で符号拡張が不要になる場合は取り除く
+// sext_inregは3命令なので、ANDI 1命令のマスクに置き換えた方が安い
+static SDValue PerformSETCCCombine(SDNode *N, SelectionDAG &DAG) {
+  DebugLoc dl = N->getDebugLoc();
+  SDValue LHS = N->getOperand(0);
+  SDValue RHS = N->getOperand(1);
+  ISD::CondCode CC = cast<CondCodeSDNode>(N->getOperand(2))->get();
+  EVT VT = LHS.getValueType();
+
+  if (VT != MVT::i32)
+    return SDValue();
+
+  if (LHS.getOpcode() != ISD::SIGN_EXTEND_INREG) {
+    if (RHS.getOpcode() != ISD::SIGN_EXTEND_INREG)
+      return SDValue();
+    std::swap(LHS, RHS);
+    CC = ISD::getSetCCSwappedOperands(CC);
+  }
+
+  EVT ExtVT = cast<VTSDNode>(LHS.getOperand(1))->getVT();
+  unsigned Bits = ExtVT.getSizeInBits();
+  SDValue X = LHS.getOperand(0);
+  SDValue Mask = DAG.getConstant((1U << Bits) - 1, MVT::i32);
+  SDValue Zero = DAG.getConstant(0, MVT::i32);
+
+  // 既に符号拡張された値なら何もしなくてよい
+  if (DAG.ComputeNumSignBits(X) > 32 - Bits)
+    return DAG.getSetCC(dl, N->getValueType(0), X, RHS, CC);
+
+  // x < 0, x > -1 は符号ビットだけ見ればよい
+  if (ConstantSDNode *C = dyn_cast<ConstantSDNode>(RHS)) {
+    int64_t Val = C->getSExtValue();
+    SDValue SignBit = DAG.getConstant(1U << (Bits - 1), MVT::i32);
+    if ((CC == ISD::SETLT && Val == 0) || (CC == ISD::SETGT && Val == -1)) {
+      SDValue And = DAG.getNode(ISD::AND, dl, MVT::i32, X, SignBit);
+      return DAG.getSetCC(dl, N->getValueType(0), And, Zero,
+                          CC == ISD::SETLT ? ISD::SETNE : ISD::SETEQ);
+    }
+  }
+
+  if (CC != ISD::SETEQ && CC != ISD::SETNE)
+    return SDValue();
+
+  // 等価比較は下位Bitsビットだけ比べればよい
+  if (ConstantSDNode *C = dyn_cast<ConstantSDNode>(RHS)) {
+    int64_t Val = C->getSExtValue();
+    if (Val < -(1LL << (Bits - 1)) || Val >= (1LL << (Bits - 1)))
+      return SDValue();
+    SDValue And = DAG.getNode(ISD::AND, dl, MVT::i32, X, Mask);
+    return DAG.getSetCC(dl, N->getValueType(0), And,
+                        DAG.getConstant(Val & ((1LL << Bits) - 1), MVT::i32),
+                        CC);
+  }
+
+  if (RHS.getOpcode() == ISD::SIGN_EXTEND_INREG &&
+      cast<VTSDNode>(RHS.getOperand(1))->getVT() == ExtVT) {
+    SDValue Xor = DAG.getNode(ISD::XOR, dl, MVT::i32, X, RHS.getOperand(0));
+    SDValue And = DAG.getNode(ISD::AND, dl, MVT::i32, Xor, Mask);
+    return DAG.getSetCC(dl, N->getValueType(0), And, Zero, CC);
+  }
+
+  return SDValue();
+}
+
+// (br (brcond (setcc a, b, cc), T), F)
+//   -> (br (brcond (setcc a, b, !cc), F), T)
+// >=, <=の比較分岐命令はないので, 逆の条件(<, >)にして行き先を入れ替える
+static SDValue PerformBRCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue BrCond = N->getOperand(0);
+  if (BrCond.getOpcode() != ISD::BRCOND || !BrCond.hasOneUse())
+    return SDValue();
+
+  SDValue Cond = BrCond.getOperand(1);
+  if (Cond.getOpcode() != ISD::SETCC || !Cond.hasOneUse())
+    return SDValue();
+
+  ISD::CondCode CC = cast<CondCodeSDNode>(Cond.getOperand(2))->get();
+  if (CC != ISD::SETGE && CC != ISD::SETLE &&
+      CC != ISD::SETUGE && CC != ISD::SETULE)
+    return SDValue();
+
+  DebugLoc dl = N->getDebugLoc();
+  SDValue NewCond = DAG.getSetCC(dl, Cond.getValueType(), Cond.getOperand(0),
+                                 Cond.getOperand(1),
+                                 ISD::getSetCCInverse(CC, true));
+  SDValue NewBrCond = DAG.getNode(ISD::BRCOND, dl, MVT::Other,
+                                  BrCond.getOperand(0), NewCond,
+                                  N->getOperand(1));
+  return DAG.getNode(ISD::BR, dl, MVT::Other, NewBrCond,
+                     BrCond.getOperand(2));
+}
+
+/// matchMinMax - (select_cc x, c, ...)が定数とのmin(x, C)かmax(x, C)なら
+/// XとCを返す. 比較の定数はCと1違ってもよい (x < C+1 ? x : C).
+static bool matchMinMax(SDValue N, SDValue &X, int64_t &C, bool &IsMax) {
+  if (N.getOpcode() != ISD::SELECT_CC || N.getValueType() != MVT::i32)
+    return false;
+
+  SDValue LHS = N.getOperand(0);
+  ConstantSDNode *CmpC = dyn_cast<ConstantSDNode>(N.getOperand(1));
+  if (!CmpC)
+    return false;
+
+  SDValue Other;
+  bool XIfTrue;
+  if (N.getOperand(2) == LHS) {
+    Other = N.getOperand(3);
+    XIfTrue = true;
+  } else if (N.getOperand(3) == LHS) {
+    Other = N.getOperand(2);
+    XIfTrue = false;
+  } else
+    return false;
+  ConstantSDNode *SelC = dyn_cast<ConstantSDNode>(Other);
+  if (!SelC)
+    return false;
+
+  // Bound: 条件が真になる最後(<, <=)か最初(>, >=)のx
+  int64_t Cmp = CmpC->getSExtValue();
+  int64_t Sel = SelC->getSExtValue();
+  bool Less;
+  int64_t Bound;
+  switch (cast<CondCodeSDNode>(N.getOperand(4))->get()) {
+  case ISD::SETLT: Less = true;  Bound = Cmp - 1; break;
+  case ISD::SETLE: Less = true;  Bound = Cmp;     break;
+  case ISD::SETGT: Less = false; Bound = Cmp + 1; break;
+  case ISD::SETGE: Less = false; Bound = Cmp;     break;
+  default:
+    return false;
+  }
+  if (Less ? (Bound != Sel - 1 && Bound != Sel)
+           : (Bound != Sel && Bound != Sel + 1))
+    return false;
+
+  X = LHS;
+  C = Sel;
+  IsMax = Less != XIfTrue;
+  return true;
+}
+
+// ビットフィールドへの書き込み
+// (or (and x, ~m), (and y, m)) -> (xor x, (and (xor x, y), m))
+// マスクが1つで済む. 片方が16bitに収まるならANDIで使えるそちらを選ぶ.
+static SDValue PerformBitfieldInsertCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue N0 = N->getOperand(0);
+  SDValue N1 = N->getOperand(1);
+  EVT VT = N->getValueType(0);
+  if (VT != MVT::i32 || N0.getOpcode() != ISD::AND ||
+      N1.getOpcode() != ISD::AND || !N0.hasOneUse() || !N1.hasOneUse())
+    return SDValue();
+
+  ConstantSDNode *C0 = dyn_cast<ConstantSDNode>(N0.getOperand(1));
+  ConstantSDNode *C1 = dyn_cast<ConstantSDNode>(N1.getOperand(1));
+  if (!C0 || !C1 ||
+      (uint32_t)C0->getZExtValue() != (uint32_t)~C1->getZExtValue())
+    return SDValue();
+
+  // Keep側(x)のビットはマスクの外, Insert側(y)はマスクの中
+  SDValue Keep = N0.getOperand(0);
+  SDValue Insert = N1.getOperand(0);
+  uint32_t Mask = C1->getZExtValue();
+  if (!isUInt<16>(Mask) && isUInt<16>((uint32_t)C0->getZExtValue())) {
+    std::swap(Keep, Insert);
+    Mask = C0->getZExtValue();
+  }
+
+  DebugLoc dl = N->getDebugLoc();
+  SDValue Diff = DAG.getNode(ISD::XOR, dl, VT, Keep, Insert);
+  return DAG.getNode(ISD::XOR, dl, VT, Keep,
+                     DAG.getNode(ISD::AND, dl, VT, Diff,
+                                 DAG.getConstant(Mask, VT)));
+}
+
+// 定数へのクランプ min(max(x, lo), hi), max(min(x, hi), lo) を1つにまとめる.
+// 2つのselectを別々にマスクで選ぶより短い.
+//   [-2^k, 2^k-1]: m = x >> 31 (算術), 範囲外 <=> ((x ^ m) >>u k) != 0,
+//                  飽和値 = m ^ (2^k-1)
+//   [0, 2^k-1]:    範囲外 <=> (x >>u k) != 0, 飽和値 = ((x >>u 31) - 1) & (2^k-1)
+// 結果 = x ^ ((x ^ 飽和値) & -(範囲外))
+static SDValue PerformSELECT_CCCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue Inner, X;
+  int64_t OuterC, InnerC;
+  bool OuterMax, InnerMax;
+  if (!matchMinMax(SDValue(N, 0), Inner, OuterC, OuterMax) ||
+      !matchMinMax(Inner, X, InnerC, InnerMax) ||
+      OuterMax == InnerMax || !Inner.hasOneUse())
+    return SDValue();
+
+  int64_t Lo = OuterMax ? OuterC : InnerC;
+  int64_t Hi = OuterMax ? InnerC : OuterC;
+  if (Hi <= 0 || !isPowerOf2_64(Hi + 1))
+    return SDValue();
+  unsigned K = Log2_64(Hi + 1);
+  if (K > 16 || (Lo != 0 && Lo != -Hi - 1))
+    return SDValue();
+
+  DebugLoc dl = N->getDebugLoc();
+  EVT VT = MVT::i32;
+  SDValue Zero = DAG.getConstant(0, VT);
+  SDValue SignShift = DAG.getConstant(31, VT);
+  SDValue HiC = DAG.getConstant(Hi, VT);
+  SDValue Out, Sat;
+  if (Lo == 0) {
+    Out = DAG.getNode(ISD::SRL, dl, VT, X, DAG.getConstant(K, VT));
+    SDValue NonNeg = DAG.getNode(ISD::ADD, dl, VT,
+                                 DAG.getNode(ISD::SRL, dl, VT, X, SignShift),
+                                 DAG.getConstant(-1, VT));
+    Sat = DAG.getNode(ISD::AND, dl, VT, NonNeg, HiC);
+  } else {
+    SDValue Sign = DAG.getNode(ISD::SRA, dl, VT, X, SignShift);
+    Out = DAG.getNode(ISD::SRL, dl, VT,
+                      DAG.getNode(ISD::XOR, dl, VT, X, Sign),
+                      DAG.getConstant(K, VT));
+    Sat = DAG.getNode(ISD::XOR, dl, VT, Sign, HiC);
+  }
+
+  // Outは2^31未満なので, -Outの符号ビットがOut != 0を表す
+  SDValue Mask = DAG.getNode(ISD::SRA, dl, VT,
+                             DAG.getNode(ISD::SUB, dl, VT, Zero, Out),
+                             SignShift);
+  SDValue Diff = DAG.getNode(ISD::XOR, dl, VT, X, Sat);
+  return DAG.getNode(ISD::XOR, dl, VT, X,
+                     DAG.getNode(ISD::AND, dl, VT, Diff, Mask));
+}
+
+/// isByteMask - Maskが1バイト分(0xff << 8 * Byte)か
+static bool isByteMask(uint64_t Mask, int &Byte) {
+  for (Byte = 0; Byte != 4; ++Byte)
+    if (Mask == (0xffULL << (8 * Byte)))
+      return true;
+  return false;
+}
+
+/// matchByteMove - Vがxの1バイトを別の位置へ動かすだけの式なら, xと
+/// 元のバイト位置Src, 行き先Dstを返す. バイト0が最下位.
+///   (shl x, 24), (srl x, 24)
+///   (and (shl/srl x, 8k), 0xff << 8d)
+///   (shl/srl (and x, 0xff << 8s), 8k)
+static bool matchByteMove(SDValue V, SDValue &X, int &Src, int &Dst) {
+  if (V.getOpcode() == ISD::AND) {
+    ConstantSDNode *M = dyn_cast<ConstantSDNode>(V.getOperand(1));
+    SDValue Sh = V.getOperand(0);
+    if (!M || (Sh.getOpcode() != ISD::SHL && Sh.getOpcode() != ISD::SRL))
+      return false;
+    ConstantSDNode *Amt = dyn_cast<ConstantSDNode>(Sh.getOperand(1));
+    if (!Amt || Amt->getZExtValue() % 8 != 0 || Amt->getZExtValue() >= 32 ||
+        !isByteMask(M->getZExtValue(), Dst))
+      return false;
+    int K = Amt->getZExtValue() / 8;
+    X = Sh.getOperand(0);
+    Src = Sh.getOpcode() == ISD::SHL ? Dst - K : Dst + K;
+    return Src >= 0 && Src < 4;
+  }
+
+  if (V.getOpcode() != ISD::SHL && V.getOpcode() != ISD::SRL)
+    return false;
+  ConstantSDNode *Amt = dyn_cast<ConstantSDNode>(V.getOperand(1));
+  if (!Amt || Amt->getZExtValue() % 8 != 0 || Amt->getZExtValue() >= 32)
+    return false;
+  int K = Amt->getZExtValue() / 8;
+  bool Left = V.getOpcode() == ISD::SHL;
+  SDValue A = V.getOperand(0);
+
+  // 24bitのシフトでは残るのが1バイトだけなのでマスクはいらない
+  if (K == 3) {
+    X = A;
+    Src = Left ? 0 : 3;
+    Dst = Left ? 3 : 0;
+    return true;
+  }
+
+  if (A.getOpcode() != ISD::AND)
+    return false;
+  ConstantSDNode *M = dyn_cast<ConstantSDNode>(A.getOperand(1));
+  if (!M || !isByteMask(M->getZExtValue(), Src))
+    return false;
+  X = A.getOperand(0);
+  Dst = Left ? Src + K : Src - K;
+  return Dst >= 0 && Dst < 4;
+}
+
+/// collectOrLeaves - ORの木の葉を集める. 途中のORは他で使われていないこと
+static bool collectOrLeaves(SDValue V, SmallVectorImpl<SDValue> &Leaves) {
+  if (V.getOpcode() != ISD::OR) {
+    Leaves.push_back(V);
+    return Leaves.size() <= 4;
+  }
+  if (!V.hasOneUse())
+    return false;
+  return collectOrLeaves(V.getOperand(0), Leaves) &&
+         collectOrLeaves(V.getOperand(1), Leaves);
+}
+
+// 手書きのバイト入れ替え
+//   (x << 24) | ((x << 8) & 0xff0000) | ((x >> 8) & 0xff00) | (x >> 24)
+// などの4バイトの入れ替えをBSWAPにする. LowerBSWAPの形は16bitに収まる
+// マスクしか使わないので, 0xff0000のようなマスクのLoadImm32がなくなる.
+// 汎用のMatchBSwapHWordはBSWAPがCustomでは働かない.
+static SDValue PerformBSwapCombine(SDNode *N, SelectionDAG &DAG) {
+  if (N->getValueType(0) != MVT::i32)
+    return SDValue();
+
+  SmallVector<SDValue, 4> Leaves;
+  if (!collectOrLeaves(N->getOperand(0), Leaves) ||
+      !collectOrLeaves(N->getOperand(1), Leaves) || Leaves.size() != 4)
+    return SDValue();
+
+  SDValue X;
+  unsigned Seen = 0;
+  for (unsigned i = 0; i != 4; ++i) {
+    SDValue LX;
+    int Src, Dst;
+    if (!matchByteMove(Leaves[i], LX, Src, Dst) || Src + Dst != 3 ||
+        (Seen & (1U << Dst)) || (X.getNode() && LX != X))
+      return SDValue();
+    X = LX;
+    Seen |= 1U << Dst;
+  }
+
+  return DAG.getNode(ISD::BSWAP, N->getDebugLoc(), MVT::i32, X);
+}
+
+// (srl (bswap x), 16) -> ((x & 0xff) << 8) | ((x >> 8) & 0xff)
+// i16のbswapは型の合法化でこの形になる. 32bitの入れ替え9命令とシフトの
+// 代わりに4命令で済む.
+static SDValue PerformSRLCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue N0 = N->getOperand(0);
+  ConstantSDNode *Amt = dyn_cast<ConstantSDNode>(N->getOperand(1));
+  EVT VT = N->getValueType(0);
+  if (VT != MVT::i32 || N0.getOpcode() != ISD::BSWAP || !N0.hasOneUse() ||
+      !Amt || Amt->getZExtValue() != 16)
+    return SDValue();
+
+  DebugLoc dl = N->getDebugLoc();
+  SDValue X = N0.getOperand(0);
+  SDValue Eight = DAG.getConstant(8, VT);
+  SDValue Low = DAG.getConstant(0xff, VT);
+  return DAG.getNode(ISD::OR, dl, VT,
+                     DAG.getNode(ISD::SHL, dl, VT,
+                                 DAG.getNode(ISD::AND, dl, VT, X, Low), Eight),
+                     DAG.getNode(ISD::AND, dl, VT,
+                                 DAG.getNode(ISD::SRL, dl, VT, X, Eight), Low));
+}
+
+// (and (seteq a, b), (seteq c, d)) -> (seteq (or (xor a, b), (xor c, d)), 0)
+// (or  (setne a, b), (setne c, d)) -> (setne (or (xor a, b), (xor c, d)), 0)
+// 分岐2つ(と遅延スロット2つ)か比較2つの代わりにXORR 2つとORR 1つで済む
+static SDValue PerformLogicSetCCCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue N0 = N->getOperand(0);
+  SDValue N1 = N->getOperand(1);
+  if (N0.getOpcode() != ISD::SETCC || N1.getOpcode() != ISD::SETCC ||
+      !N0.hasOneUse() || !N1.hasOneUse())
+    return SDValue();
+
+  ISD::CondCode CC = N->getOpcode() == ISD::AND ? ISD::SETEQ : ISD::SETNE;
+  if (cast<CondCodeSDNode>(N0.getOperand(2))->get() != CC ||
+      cast<CondCodeSDNode>(N1.getOperand(2))->get() != CC)
+    return SDValue();
+
+  EVT VT = N0.getOperand(0).getValueType();
+  if (!VT.isInteger() || N1.getOperand(0).getValueType() != VT)
+    return SDValue();
+
+  DebugLoc dl = N->getDebugLoc();
+  SDValue X0 = DAG.getNode(ISD::XOR, dl, VT, N0.getOperand(0),
+                           N0.getOperand(1));
+  SDValue X1 = DAG.getNode(ISD::XOR, dl, VT, N1.getOperand(0),
+                           N1.getOperand(1));
+  return DAG.getSetCC(dl, N->getValueType(0),
+                      DAG.getNode(ISD::OR, dl, VT, X0, X1),
+                      DAG.getConstant(0, VT), CC);
+}
+
+SDValue AZPRTargetLowering::PerformDAGCombine(SDNode *N,
+                                              DAGCombinerInfo &DCI) const {
+  SelectionDAG &DAG = DCI.DAG;
+
+  switch (N->getOpcode()) {
+  default: break;
+  case ISD::SETCC:
+    return PerformSETCCCombine(N, DAG);
+  case ISD::BR:
+    return PerformBRCombine(N, DAG);
+  case ISD::AND:
+    return PerformLogicSetCCCombine(N, DAG);
+  case ISD::OR: {
+    SDValue Res = PerformLogicSetCCCombine(N, DAG);
+    if (Res.getNode())
+      return Res;
+    // BSWAPは演算の合法化で展開されるので, その後には作らない
+    if (DCI.isBeforeLegalizeOps()) {
+      Res = PerformBSwapCombine(N, DAG);
+      if (Res.getNode())
+        return Res;
+    }
+    return PerformBitfieldInsertCombine(N, DAG);
+  }
+  case ISD::SELECT_CC:
+    return PerformSELECT_CCCombine(N, DAG);
+  case ISD::SRL:
+    if (DCI.isBeforeLegalizeOps())
+      return PerformSRLCombine(N, DAG);
+    break;
+  }
+
+  return SDValue();
+}
+
 //===----------------------------------------------------------------------===//
 //                      Calling Convention Implementation
 //===----------------------------------------------------------------------===//
@@ -453,6 +1440,8 @@ LowerCall(CallLoweringInfo &CLI,
 
   if (GlobalAddressSDNode *G = dyn_cast<GlobalAddressSDNode>(Callee)) {
     Callee = DAG.getTargetGlobalAddress(G->getGlobal(), dl, MVT::i32);
+    if (getTargetMachine().getCodeModel() == CodeModel::Small)
+      Callee = DAG.getNode(AZPRISD::Abs16, dl, MVT::i32, Callee);
     DEBUG(dbgs() << "  Global: " << Callee.getNode() << "\n");
   } else if (ExternalSymbolSDNode *E = dyn_cast<ExternalSymbolSDNode>(Callee)) {
     Callee = DAG.getTargetExternalSymbol(E->getSymbol(), MVT::i32);
@@ -693,3 +1682,117 @@ AZPRTargetLowering::EmitInstrWithCustomInserter(MachineInstr *MI,
   MI->eraseFromParent();
   return exitMBB;
 }
+
+bool AZPRTargetLowering::isLegalAddressingMode(const AddrMode &AM,
+                                               Type *Ty) const {
+  // グローバル変数のアドレスはレジスタに作る必要がある
+  if (AM.BaseGV)
+    return false;
+
+  if (!isInt<16>(AM.BaseOffs))
+    return false;
+
+  switch (AM.Scale) {
+  case 0: // "r+i" or just "i"
+    return true;
+  case 1: // "r+i"
+    return !AM.HasBaseReg;
+  default: // "r+r"やスケールはない
+    return false;
+  }
+}
+
+bool AZPRTargetLowering::isLegalICmpImmediate(int64_t Imm) const {
+  return Imm == 0;
+}
+
+bool AZPRTargetLowering::isLegalAddImmediate(int64_t Imm) const {
+  return isInt<16>(Imm);
+}
+
+bool AZPRTargetLowering::isTruncateFree(Type *Ty1, Type *Ty2) const {
+  if (!Ty1->isIntegerTy() || !Ty2->isIntegerTy())
+    return false;
+  return Ty1->getPrimitiveSizeInBits() > Ty2->getPrimitiveSizeInBits();
+}
+
+bool AZPRTargetLowering::isTruncateFree(EVT VT1, EVT VT2) const {
+  if (!VT1.isInteger() || !VT2.isInteger())
+    return false;
+  return VT1.getSizeInBits() > VT2.getSizeInBits();
+}
+
+//===----------------------------------------------------------------------===//
+//                    AZPR TargetTransformInfo
+//===----------------------------------------------------------------------===//
+
+// 乗除算はライブラリ呼び出し. 引数の受け渡しと呼び出し, 遅延スロット,
+// ループでの演算を含めた概算
+static const unsigned LibCallCost = 20;
+
+unsigned
+AZPRVectorTargetTransformInfo::getArithmeticInstrCost(unsigned Opcode,
+                                                      Type *Ty) const {
+  if (!Ty->isIntegerTy())
+    return VectorTargetTransformImpl::getArithmeticInstrCost(Opcode, Ty);
+
+  switch (Opcode) {
+  case Instruction::Mul:
+  case Instruction::UDiv:
+  case Instruction::SDiv:
+  case Instruction::URem:
+  case Instruction::SRem:
+    return LibCallCost;
+  case Instruction::AShr:
+    // SRA命令はないので符号マスクとSHRLから作る
+    return 4;
+  default:
+    return VectorTargetTransformImpl::getArithmeticInstrCost(Opcode, Ty);
+  }
+}
+
+unsigned
+AZPRVectorTargetTransformInfo::getCastInstrCost(unsigned Opcode, Type *Dst,
+                                                Type *Src) const {
+  if (Src->isIntegerTy() && Dst->isIntegerTy()) {
+    unsigned SrcBits = Src->getIntegerBitWidth();
+    switch (Opcode) {
+    case Instruction::Trunc:
+      return 0;
+    case Instruction::ZExt:
+      return 1; // ANDI
+    case Instruction::SExt:
+      // i1はSUBUR r0, 8/16bitはANDI, XORI, ADDUI
+      return SrcBits == 1 ? 1 : 3;
+    default:
+      break;
+    }
+  }
+  return VectorTargetTransformImpl::getCastInstrCost(Opcode, Dst, Src);
+}
+
+unsigned AZPRVectorTargetTransformInfo::getCFInstrCost(unsigned Opcode) const {
+  // 分岐には遅延スロットがある
+  if (Opcode == Instruction::Br || Opcode == Instruction::Ret ||
+      Opcode == Instruction::Switch || Opcode == Instruction::IndirectBr)
+    return 2;
+  return VectorTargetTransformImpl::getCFInstrCost(Opcode);
+}
+
+unsigned
+AZPRVectorTargetTransformInfo::getMemoryOpCost(unsigned Opcode, Type *Src,
+                                               unsigned Alignment,
+                                               unsigned AddressSpace) const {
+  if (Src->isIntegerTy()) {
+    unsigned Bits = Src->getIntegerBitWidth();
+    // バイト/ハーフワードはワード単位のアクセスとシフト, マスクで行う.
+    // ストアは読み出して書き戻す.
+    if (Bits < 32)
+      return Opcode == Instruction::Store ? 10 : 6;
+    // アラインされていないワードアクセスはバイト単位に分割される
+    if (Alignment && Alignment < 4)
+      return Opcode == Instruction::Store ? 40 : 24;
+  }
+  return VectorTargetTransformImpl::getMemoryOpCost(Opcode, Src, Alignment,
+                                                    AddressSpace);
+}
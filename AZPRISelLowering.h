@@ -19,6 +19,7 @@
 #include "AZPRSubtarget.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/Target/TargetLowering.h"
+#include "llvm/Target/TargetTransformImpl.h"
 
 namespace llvm {
 namespace AZPRISD {
@@ -33,7 +34,18 @@ namespace AZPRISD {
 
     Hi,
     Lo,
-    Or
+    Or,
+
+    // Offset of a small data object from the global pointer
+    GPRel,
+
+    // Whole address under the small code model
+    Abs16,
+
+    // Signed add/sub that raise the overflow exception (addsr/subsr/addsi).
+    // Operand 0 is the chain.
+    AddTrap,
+    SubTrap
   };
 }
 
@@ -96,10 +108,71 @@ class AZPRTargetLowering : public TargetLowering {
       EmitInstrWithCustomInserter(MachineInstr *MI,
                                   MachineBasicBlock *MBB) const;
 
+    /// PerformDAGCombine - AZPR specific DAG combines.
+    virtual SDValue PerformDAGCombine(SDNode *N, DAGCombinerInfo &DCI) const;
+
+    /// isLegalAddressingMode - LDW/STWはベースレジスタ+符号付き16bit
+    /// オフセットのみ
+    virtual bool isLegalAddressingMode(const AddrMode &AM, Type *Ty) const;
+
+    /// isLegalICmpImmediate - 比較命令は即値を取れないので, r0と比べられる
+    /// 0だけが無料. LSRがループを0に向かって数えるようにする.
+    virtual bool isLegalICmpImmediate(int64_t Imm) const;
+
+    /// isLegalAddImmediate - ADDUIの符号付き16bit即値
+    virtual bool isLegalAddImmediate(int64_t Imm) const;
+
+    /// isTruncateFree - レジスタは32bitなので縮小は命令を必要としない
+    virtual bool isTruncateFree(Type *Ty1, Type *Ty2) const;
+    virtual bool isTruncateFree(EVT VT1, EVT VT2) const;
+
+    /// getMaximalGlobalOffset - GlobalMergeでまとめたグローバル変数には
+    /// LDW/STWの16bitオフセットで届くようにする
+    virtual unsigned getMaximalGlobalOffset() const {
+      return 0x7fff;
+    }
+
+    /// isOffsetFoldingLegal - PICはないのでアドレスは常に絶対値. (add sym, c)
+    /// をsym+cにまとめてhigh_a/low/abs/gp_relの加数にする
+    virtual bool isOffsetFoldingLegal(const GlobalAddressSDNode *GA) const {
+      return true;
+    }
+
  private:
     SDValue LowerGlobalAddress(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerConstantPool(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerJumpTable(SDValue Op, SelectionDAG &DAG) const;
     SDValue LowerLOAD(SDValue Op, SelectionDAG &DAG) const;
     SDValue LowerSTORE(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerSETCC(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerSELECT_CC(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerCTPOP(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerCTLZ(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerCTTZ(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerRotate(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerBSWAP(SDValue Op, SelectionDAG &DAG) const;
+    SDValue LowerXALUO(SDValue Op, SelectionDAG &DAG) const;
+};
+
+/// AZPRVectorTargetTransformInfo - Costs of IR instructions on AZPR.
+/// Multiply and divide are library calls, sign extension and arithmetic
+/// shifts take several instructions, byte accesses go through a word
+/// access, and every taken branch pays a delay slot.
+class AZPRVectorTargetTransformInfo : public VectorTargetTransformImpl {
+public:
+  explicit AZPRVectorTargetTransformInfo(const TargetLowering *TL) :
+    VectorTargetTransformImpl(TL) {}
+
+  virtual unsigned getArithmeticInstrCost(unsigned Opcode, Type *Ty) const;
+
+  virtual unsigned getCastInstrCost(unsigned Opcode, Type *Dst,
+                                    Type *Src) const;
+
+  virtual unsigned getCFInstrCost(unsigned Opcode) const;
+
+  virtual unsigned getMemoryOpCost(unsigned Opcode, Type *Src,
+                                   unsigned Alignment,
+                                   unsigned AddressSpace) const;
 };
 } // end of namespace llvm
 
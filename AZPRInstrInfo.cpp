@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "AZPRInstrInfo.h"
+#include "AZPRAnalyzeImmediate.h"
 #include "AZPRTargetMachine.h"
 #include "AZPRMachineFunction.h"
 #include "MCTargetDesc/AZPRMCTargetDesc.h"
@@ -146,7 +147,8 @@ loadRegFromStackSlot(MachineBasicBlock &MBB,
 //===----------------------------------------------------------------------===//
 
 unsigned AZPRInstrInfo::GetAnalyzableBrOpc(unsigned Opc) const {
-  return (Opc == AZPR::BE || Opc == AZPR::BNE) ?
+  return (Opc == AZPR::BE || Opc == AZPR::BNE ||
+          Opc == AZPR::BSGT || Opc == AZPR::BUGT) ?
          Opc : 0;
 }
 
@@ -331,3 +333,63 @@ RemoveBranch(MachineBasicBlock &MBB) const
 
   return removed;
 }
+
+//===----------------------------------------------------------------------===//
+// Pseudo Expansion
+//===----------------------------------------------------------------------===//
+
+bool AZPRInstrInfo::
+expandPostRAPseudo(MachineBasicBlock::iterator MI) const {
+  MachineBasicBlock &MBB = *MI->getParent();
+
+  switch (MI->getDesc().getOpcode()) {
+  default:
+    return false;
+  case AZPR::LoadAddr:
+    ExpandLoadAddr(MBB, MI);
+    break;
+  case AZPR::LoadImm32:
+    loadImmediate(MBB, MI, MI->getDebugLoc(), MI->getOperand(0).getReg(),
+                  (uint32_t)MI->getOperand(1).getImm());
+    break;
+  case AZPR::LoadAddrHA: {
+    unsigned DstReg = MI->getOperand(0).getReg();
+    BuildMI(MBB, MI, MI->getDebugLoc(), get(AZPR::LoadHA16), DstReg)
+      .addOperand(MI->getOperand(1));
+    BuildMI(MBB, MI, MI->getDebugLoc(), get(AZPR::SHLLI), DstReg)
+      .addReg(DstReg).addImm(16);
+    break;
+  }
+  }
+
+  MBB.erase(MI);
+  return true;
+}
+
+void AZPRInstrInfo::
+loadImmediate(MachineBasicBlock &MBB, MachineBasicBlock::iterator I,
+              DebugLoc DL, unsigned DstReg, uint32_t Imm) const {
+  AZPRAnalyzeImmediate AnalyzeImm;
+  const AZPRAnalyzeImmediate::InstSeq &Seq = AnalyzeImm.Analyze(Imm);
+  unsigned SrcReg = AZPR::r0;
+
+  for (unsigned i = 0, e = Seq.size(); i != e; ++i) {
+    BuildMI(MBB, I, DL, get(Seq[i].Opc), DstReg)
+      .addReg(SrcReg).addImm(Seq[i].ImmOpnd);
+    SrcReg = DstReg;
+  }
+}
+
+// ori r0, high_a(sym), dst; shlli dst, 16, dst; addui dst, low(sym), dst
+// high_aはlowの符号拡張分を繰り上げた値(R_MIPS_HI16と同じ意味)
+void AZPRInstrInfo::
+ExpandLoadAddr(MachineBasicBlock &MBB, MachineBasicBlock::iterator I) const {
+  DebugLoc DL = I->getDebugLoc();
+  unsigned DstReg = I->getOperand(0).getReg();
+  const MachineOperand &Sym = I->getOperand(1);
+
+  BuildMI(MBB, I, DL, get(AZPR::CALLLoadHI16), DstReg).addOperand(Sym);
+  BuildMI(MBB, I, DL, get(AZPR::SHLLI), DstReg).addReg(DstReg).addImm(16);
+  BuildMI(MBB, I, DL, get(AZPR::CALLADDUILO16), DstReg)
+    .addReg(DstReg).addOperand(Sym);
+}
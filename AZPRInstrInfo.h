@@ -86,7 +86,17 @@ public:
                                 MachineBasicBlock *FBB,
                                 const SmallVectorImpl<MachineOperand> &Cond,
                                 DebugLoc DL) const;
+
+  /// expandPostRAPseudo - Expand LoadAddr and LoadImm32.
+  virtual bool expandPostRAPseudo(MachineBasicBlock::iterator MI) const;
+
+  /// loadImmediate - Emit the shortest sequence that sets DstReg to Imm.
+  void loadImmediate(MachineBasicBlock &MBB, MachineBasicBlock::iterator I,
+                     DebugLoc DL, unsigned DstReg, uint32_t Imm) const;
 private:
+  void ExpandLoadAddr(MachineBasicBlock &MBB,
+                      MachineBasicBlock::iterator I) const;
+
   unsigned GetAnalyzableBrOpc(unsigned Opc) const;
 
   void BuildCondBr(MachineBasicBlock &MBB,
@@ -13,6 +13,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "AZPRMCInstLower.h"
+#include "AZPRMachineFunction.h"
+#include "MCTargetDesc/AZPRBaseInfo.h"
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -34,14 +36,18 @@ MCOperand AZPRMCInstLower::
 LowerSymbolOperand(const MachineOperand &MO,
                    MachineOperandType MOTy) const {
   DEBUG(dbgs() << ">>> LowerSymbolOperand <<<\n");
+  MCSymbolRefExpr::VariantKind Kind = MCSymbolRefExpr::VK_None;
 
   switch(MO.getTargetFlags()) {
     default: llvm_unreachable("Invalid target flag!");
-    case 0: break;
+    case AZPRII::MO_NO_FLAG: break;
+    case AZPRII::MO_CPREL: break;
+    case AZPRII::MO_ABS_LO: Kind = MCSymbolRefExpr::VK_Mips_ABS_LO; break;
+    case AZPRII::MO_GPREL:  Kind = MCSymbolRefExpr::VK_Mips_GPREL; break;
   }
 
   const MCSymbol *Symbol;
-  unsigned Offset = 0;
+  int64_t Offset = 0;
   switch (MOTy) {
   case MachineOperand::MO_MachineBasicBlock:
     Symbol = MO.getMBB()->getSymbol();
@@ -67,7 +73,18 @@ LowerSymbolOperand(const MachineOperand &MO,
     llvm_unreachable("<unknown operand type>");
   }
 
-  const MCExpr *Expr = MCSymbolRefExpr::Create(Symbol, Ctx);
+  const MCExpr *Expr = MCSymbolRefExpr::Create(Symbol, Kind, Ctx);
+
+  // コンスタントプールのベースからの差
+  if (MO.getTargetFlags() == AZPRII::MO_CPREL) {
+    const AZPRMachineFunctionInfo *AFI =
+      Printer.MF->getInfo<AZPRMachineFunctionInfo>();
+    assert(AFI->getConstantPoolBaseIndex() >= 0 && "No constant pool base!");
+    const MCSymbol *Base =
+      Printer.GetCPISymbol(AFI->getConstantPoolBaseIndex());
+    Expr = MCBinaryExpr::CreateSub(Expr, MCSymbolRefExpr::Create(Base, Ctx),
+                                   Ctx);
+  }
 
   if (Offset) {
     const MCConstantExpr *OffsetExpr =  MCConstantExpr::Create(Offset, Ctx);
@@ -25,8 +25,23 @@ namespace llvm {
 class AZPRMachineFunctionInfo : public MachineFunctionInfo {
   virtual void anchor();
 
+  /// ConstantPoolBaseIndex - Constant pool entry whose address is used as the
+  /// base register for pool loads in this function, or -1 if none.
+  int ConstantPoolBaseIndex;
+
+  /// ConstantPoolBaseReg - Virtual register holding that address, defined
+  /// once in the entry block, or 0 if it has not been materialized yet.
+  unsigned ConstantPoolBaseReg;
+
 public:
-  AZPRMachineFunctionInfo(MachineFunction& MF) {}
+  AZPRMachineFunctionInfo(MachineFunction& MF)
+    : ConstantPoolBaseIndex(-1), ConstantPoolBaseReg(0) {}
+
+  int getConstantPoolBaseIndex() const { return ConstantPoolBaseIndex; }
+  void setConstantPoolBaseIndex(int Idx) { ConstantPoolBaseIndex = Idx; }
+
+  unsigned getConstantPoolBaseReg() const { return ConstantPoolBaseReg; }
+  void setConstantPoolBaseReg(unsigned Reg) { ConstantPoolBaseReg = Reg; }
 };
 } // end of namespace llvm
 
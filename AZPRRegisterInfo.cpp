@@ -15,6 +15,7 @@
 
 #include "AZPRRegisterInfo.h"
 #include "AZPR.h"
+#include "AZPRSubtarget.h"
 #include "llvm/Constants.h"
 #include "llvm/Type.h"
 #include "llvm/Function.h"
@@ -29,6 +30,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/STLExtras.h"
@@ -73,6 +75,10 @@ getReservedRegs(const MachineFunction &MF) const {
   for (unsigned I = 0; I < array_lengthof(ReservedCPURegs); ++I)
     Reserved.set(ReservedCPURegs[I]);
 
+  // スモールデータを使う場合r28はgp
+  if (MF.getTarget().getSubtarget<AZPRSubtarget>().useSmallSection())
+    Reserved.set(AZPR::r28);
+
   return Reserved;
 }
 
@@ -108,6 +114,9 @@ eliminateFrameIndex(MachineBasicBlock::iterator II, int SPAdj,
   int64_t spOffset = MF.getFrameInfo()->getObjectOffset(FrameIndex);
   int64_t Offset = spOffset + stackSize + MI.getOperand(imIndex).getImm();
   unsigned FrameReg = AZPR::r30;
+  // リリースビルドでassertが消えても黙ってオフセットを切り詰めないようにする
+  if (!isInt<16>(Offset))
+    report_fatal_error("frame offset doesn't fit in 16 bits");
 
   DEBUG(errs() 
         << "\nFunction : " << MF.getFunction()->getName() << "\n"
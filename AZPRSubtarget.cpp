@@ -13,6 +13,7 @@
 
 #include "AZPRSubtarget.h"
 #include "AZPR.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/TargetRegistry.h"
 
 #define GET_SUBTARGETINFO_TARGET_DESC
@@ -21,12 +22,21 @@
 
 using namespace llvm;
 
+static cl::opt<unsigned>
+SSThreshold("azpr-ssection-threshold", cl::Hidden,
+            cl::desc("Small data and bss section threshold size "
+                     "(default=0, no small sections)"),
+            cl::init(0));
+
 AZPRSubtarget::AZPRSubtarget(const std::string &TT,
                                  const std::string &CPU,
                                  const std::string &FS)
-    : AZPRGenSubtargetInfo(TT, CPU, FS) {
+    : AZPRGenSubtargetInfo(TT, CPU, FS), SSectionThreshold(SSThreshold) {
   std::string CPUName = "generic";
 
   // Parse features string.
   ParseSubtargetFeatures(CPUName, FS);
+
+  // Initialize scheduling itinerary for the specified CPU.
+  InstrItins = getInstrItineraryForCPU(CPUName);
 }
@@ -14,6 +14,7 @@
 #ifndef LLVM_TARGET_SAMPLE_SUBTARGET_H
 #define LLVM_TARGET_SAMPLE_SUBTARGET_H
 
+#include "llvm/MC/MCInstrItineraries.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
 #include <string>
 
@@ -26,6 +27,12 @@ class StringRef;
 class AZPRSubtarget : public AZPRGenSubtargetInfo {
   virtual void anchor() {};
   bool ExtendedInsts;
+
+  // この大きさ以下のグローバル変数は.sdata/.sbssに置き, gpからの
+  // オフセットでアクセスする. 0なら使わない.
+  unsigned SSectionThreshold;
+
+  InstrItineraryData InstrItins;
 public:
   /// This constructor initializes the data members to match that
   /// of the specified triple.
@@ -36,6 +43,11 @@ public:
   /// ParseSubtargetFeatures - Parses features string setting specified
   /// subtarget options.  Definition of function is auto generated by tblgen.
   void ParseSubtargetFeatures(StringRef CPU, StringRef FS);
+
+  bool useSmallSection() const { return SSectionThreshold != 0; }
+  unsigned getSSectionThreshold() const { return SSectionThreshold; }
+
+  const InstrItineraryData &getInstrItineraryData() const { return InstrItins; }
 };
 } // End llvm namespace
 
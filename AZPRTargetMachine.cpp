@@ -16,9 +16,43 @@
 #include "llvm/PassManager.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/MC/MCAsmInfo.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Transforms/Scalar.h"
 using namespace llvm;
 
+static cl::opt<bool> DisableGlobalMerge(
+  "disable-azpr-global-merge",
+  cl::init(false),
+  cl::desc("Disable merging of internal globals."),
+  cl::Hidden);
+
+static cl::opt<bool> DisableLoopUnroll(
+  "disable-azpr-loop-unroll",
+  cl::init(false),
+  cl::desc("Disable the AZPR loop unrolling before LSR."),
+  cl::Hidden);
+
+// ループの1回ごとに分岐と遅延スロットの2命令がかかり, 汎用レジスタも27本
+// 使えるので, 汎用の既定値(150)より大きめに展開する
+static cl::opt<unsigned> UnrollThreshold(
+  "azpr-unroll-threshold",
+  cl::init(250),
+  cl::desc("Size threshold of unrolled AZPR loops."),
+  cl::Hidden);
+
+static cl::opt<unsigned> UnrollCount(
+  "azpr-unroll-count",
+  cl::init(0),
+  cl::desc("Force this unroll count on AZPR loops (0: computed)."),
+  cl::Hidden);
+
+static cl::opt<bool> UnrollAllowPartial(
+  "azpr-unroll-allow-partial",
+  cl::init(true),
+  cl::desc("Allow partial unrolling of AZPR loops."),
+  cl::Hidden);
+
 extern "C" void LLVMInitializeAZPRTarget() {
   // Register the target.
   RegisterTargetMachine<AZPRTargetMachine> X(TheAZPRTarget);
@@ -34,7 +68,7 @@ AZPRTargetMachine(const Target &T, StringRef Triple,
       Subtarget(Triple, CPU, FS),
       InstrInfo(*this),
       FrameLowering(Subtarget),
-      TLInfo(*this), TSInfo(*this) {}
+      TLInfo(*this), TSInfo(*this), STTI(&TLInfo), VTTI(&TLInfo) {}
 
 namespace {
 /// AZPR Code Generator Pass Configuration Options.
@@ -47,7 +81,10 @@ class AZPRPassConfig : public TargetPassConfig {
     return getTM<AZPRTargetMachine>();
   }
 
+  virtual void addIRPasses();
+  virtual bool addPreISel();
   virtual bool addInstSelector();
+  virtual bool addPreRegAlloc();
   virtual bool addPreEmitPass();
 };
 } // namespace
@@ -56,12 +93,51 @@ TargetPassConfig *AZPRTargetMachine::createPassConfig(PassManagerBase &PM) {
   return new AZPRPassConfig(this, PM);
 }
 
+/// addIRPasses - LSRの前にループを展開する. 展開したアクセスのアドレスは
+/// LSRでポインタ1本からのLDW/STWのオフセットになる.
+/// 回数が実行時にしか分からないループはAZPRRuntimeUnrollで展開する.
+void AZPRPassConfig::addIRPasses() {
+  if (getOptLevel() != CodeGenOpt::None && !DisableLoopUnroll) {
+    addPass(createLoopUnrollPass(UnrollThreshold,
+                                 UnrollCount ? (int)UnrollCount : -1,
+                                 UnrollAllowPartial));
+    addPass(createAZPRRuntimeUnrollPass(UnrollThreshold));
+  }
+  TargetPassConfig::addIRPasses();
+}
+
+/// addPreISel - 内部リンケージのグローバル変数を1つにまとめ, アドレスの生成を
+/// 1回にしてLDW/STWのオフセットで各変数にアクセスする. スモールデータを
+/// 使うときは, まとめたものが閾値を越えて.sdata/.sbssから外れてしまうので
+/// まとめない(gpが共通のベースになる).
+/// LSRの後で, 1ブロックのループのロードを1つ前の繰り返しで発行し,
+/// 終了判定にしか使われない誘導変数を0へのカウントダウンにする.
+bool AZPRPassConfig::addPreISel() {
+  if (getOptLevel() == CodeGenOpt::None)
+    return false;
+
+  if (!DisableGlobalMerge &&
+      !getAZPRTargetMachine().getSubtargetImpl()->useSmallSection())
+    addPass(createGlobalMergePass(getAZPRTargetMachine().getTargetLowering()));
+  addPass(createAZPRSoftwarePipelinerPass(getAZPRTargetMachine()));
+  addPass(createAZPRCountDownLoopsPass());
+  return false;
+}
+
 bool AZPRPassConfig::addInstSelector() {
   // Install an instruction selector.
   addPass(createAZPRISelDag(getAZPRTargetMachine()));
   return false;
 }
 
+/// addPreRegAlloc - MachineLICMの後で, 近いアドレスと定数を1つのアンカーからの
+/// オフセットで作るようにする
+bool AZPRPassConfig::addPreRegAlloc() {
+  if (getOptLevel() != CodeGenOpt::None)
+    addPass(createAZPRConstantAnchorPass(getAZPRTargetMachine()));
+  return false;
+}
+
 /// addPreEmitPass - This pass may be implemented by targets that want to run
 /// passes immediately before machine code is emitted.  This should return
 /// true if -print-machineinstrs should print out the code after the passes.
@@ -36,6 +36,8 @@ class AZPRTargetMachine : public LLVMTargetMachine {
   AZPRFrameLowering FrameLowering;
   AZPRTargetLowering TLInfo;
   AZPRSelectionDAGInfo TSInfo;
+  ScalarTargetTransformImpl STTI;
+  AZPRVectorTargetTransformInfo VTTI;
 
  public:
   AZPRTargetMachine(const Target &T, StringRef TT,
@@ -61,9 +63,18 @@ class AZPRTargetMachine : public LLVMTargetMachine {
   virtual const AZPRFrameLowering *getFrameLowering() const{
     return &FrameLowering;
   }
+  virtual const InstrItineraryData *getInstrItineraryData() const {
+    return &Subtarget.getInstrItineraryData();
+  }
   virtual const AZPRSelectionDAGInfo* getSelectionDAGInfo() const {
     return &TSInfo;
   }
+  virtual const ScalarTargetTransformInfo *getScalarTargetTransformInfo()const{
+    return &STTI;
+  }
+  virtual const VectorTargetTransformInfo *getVectorTargetTransformInfo()const{
+    return &VTTI;
+  }
 
   // Pass Pipeline Configuration
   virtual TargetPassConfig *createPassConfig(PassManagerBase &PM);
@@ -734,6 +734,8 @@ bool AZPRAsmParser::parseRelocOperand(const MCExpr *&Res) {
       Val = Val & 0xffff;
     } else if (Str == "high") {
       Val = (Val & 0xffff0000) >> 16;
+    } else if (Str == "high_a") {
+      Val = (((unsigned)Val + 0x8000) & 0xffff0000) >> 16;
     } else if(Str == "pc16"){
       Val = Val & 0xffff;
     }
@@ -898,7 +900,11 @@ MCSymbolRefExpr::VariantKind AZPRAsmParser::getVariantKind(StringRef Symbol) {
     .Case("hi(%neg(%gp_rel",    MCSymbolRefExpr::VK_AZPR_GPOFF_HI)
     .Case("lo(%neg(%gp_rel",    MCSymbolRefExpr::VK_AZPR_GPOFF_LO)*/
     .Case("high",        MCSymbolRefExpr::VK_Mips_ABS_HI)
+    // 繰り上げた上位(addui, ldw, stwと組む). MIPSには種類がないので
+    // PowerPCの@haを借りる
+    .Case("high_a",      MCSymbolRefExpr::VK_PPC_GAS_HA16)
     .Case("low",         MCSymbolRefExpr::VK_Mips_ABS_LO)
+    .Case("abs",         MCSymbolRefExpr::VK_None)
     .Case("pc16",         (MCSymbolRefExpr::VariantKind)(MCSymbolRefExpr::VK_Mips_LO16 + 100))
     .Default(MCSymbolRefExpr::VK_None);
 
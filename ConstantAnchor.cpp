@@ -0,0 +1,243 @@
+//===-- ConstantAnchor.cpp - AZPR constant/address anchoring --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass rewrites LoadAddr/LoadImm32 pseudos whose value is within a signed
+// 16-bit distance of a dominating LoadAddr/LoadImm32 (the anchor) so that they
+// are computed from the anchor with one ADDUI. When the value is only used as
+// the base of LDW/STW, the distance is folded into their offset instead.
+//
+// LoadAddrHA (high half of a global whose low half sits in the LDW/STW
+// offset) joins the group of its global: when two of them can share a base,
+// the dominating one is turned into a full LoadAddr and the accesses use
+// plain offsets from it.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "azpr-constant-anchor"
+#include "AZPR.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+
+using namespace llvm;
+
+STATISTIC(NumAnchored, "Number of constants computed from an anchor");
+STATISTIC(NumFolded,   "Number of anchor offsets folded into loads/stores");
+
+static cl::opt<bool> DisableConstantAnchor(
+  "disable-azpr-constant-anchor",
+  cl::init(false),
+  cl::desc("Disable the AZPR constant anchoring pass."),
+  cl::Hidden);
+
+namespace {
+  struct ConstantAnchor : public MachineFunctionPass {
+    TargetMachine &TM;
+    const TargetInstrInfo *TII;
+    MachineRegisterInfo *MRI;
+    MachineDominatorTree *MDT;
+
+    static char ID;
+    ConstantAnchor(TargetMachine &tm)
+      : MachineFunctionPass(ID), TM(tm), TII(tm.getInstrInfo()) { }
+
+    virtual const char *getPassName() const {
+      return "AZPR Constant Anchoring";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.setPreservesCFG();
+      AU.addRequired<MachineDominatorTree>();
+      AU.addPreserved<MachineDominatorTree>();
+      MachineFunctionPass::getAnalysisUsage(AU);
+    }
+
+    bool runOnMachineFunction(MachineFunction &F);
+
+  private:
+    bool getAnchorKey(const MachineInstr *MI, const void *&Key,
+                      int64_t &Value) const;
+    bool hasOnlyLoOffsetUses(const MachineInstr *MI) const;
+    void promoteToLoadAddr(MachineInstr *MI);
+    void rebaseOnAnchor(MachineInstr *MI, MachineInstr *Anchor, int64_t Diff);
+  };
+  char ConstantAnchor::ID = 0;
+} // end of anonymous namespace
+
+/// createAZPRConstantAnchorPass - Returns a pass that computes nearby
+/// addresses and constants from one materialized anchor.
+FunctionPass *llvm::createAZPRConstantAnchorPass(TargetMachine &tm) {
+  return new ConstantAnchor(tm);
+}
+
+/// getAnchorKey - 同じKeyを持つものの間でValueの差をオフセットにできる.
+/// グローバル変数のアドレスは同じ変数の間だけ, 定数はすべて同じグループ.
+bool ConstantAnchor::getAnchorKey(const MachineInstr *MI, const void *&Key,
+                                  int64_t &Value) const {
+  switch (MI->getOpcode()) {
+  case AZPR::LoadAddrHA:
+    if (!hasOnlyLoOffsetUses(MI))
+      return false;
+    // fall through
+  case AZPR::LoadAddr: {
+    const MachineOperand &MO = MI->getOperand(1);
+    if (!MO.isGlobal())
+      return false;
+    Key = MO.getGlobal();
+    Value = MO.getOffset();
+    return true;
+  }
+  case AZPR::LoadImm32:
+    Key = 0;
+    Value = (uint32_t)MI->getOperand(1).getImm();
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// hasOnlyLoOffsetUses - LoadAddrHAの結果がすべてLDW/STWのベースとして
+/// %lo()オフセットと組で使われているか
+bool ConstantAnchor::hasOnlyLoOffsetUses(const MachineInstr *MI) const {
+  unsigned Reg = MI->getOperand(0).getReg();
+  for (MachineRegisterInfo::use_iterator UI = MRI->use_begin(Reg),
+       UE = MRI->use_end(); UI != UE; ++UI) {
+    const MachineInstr *UseMI = &*UI;
+    if ((UseMI->getOpcode() != AZPR::LDW && UseMI->getOpcode() != AZPR::STW) ||
+        UI.getOperandNo() != 1 || !UseMI->getOperand(2).isGlobal())
+      return false;
+  }
+  return true;
+}
+
+/// promoteToLoadAddr - LoadAddrHAをアドレス全体を作るLoadAddrにし,
+/// 使用側の%lo()オフセットを0にする
+void ConstantAnchor::promoteToLoadAddr(MachineInstr *MI) {
+  unsigned Reg = MI->getOperand(0).getReg();
+  for (MachineRegisterInfo::use_iterator UI = MRI->use_begin(Reg),
+       UE = MRI->use_end(); UI != UE; ++UI)
+    UI->getOperand(2).ChangeToImmediate(0);
+  MI->setDesc(TII->get(AZPR::LoadAddr));
+}
+
+/// rebaseOnAnchor - MIの結果をAnchor + Diffで置き換える
+void ConstantAnchor::rebaseOnAnchor(MachineInstr *MI, MachineInstr *Anchor,
+                                    int64_t Diff) {
+  unsigned DstReg = MI->getOperand(0).getReg();
+  unsigned AnchorReg = Anchor->getOperand(0).getReg();
+  bool AllFolded = true;
+
+  if (Anchor->getOpcode() == AZPR::LoadAddrHA)
+    promoteToLoadAddr(Anchor);
+
+  // ベースとして使われている所はオフセットに畳み込む
+  for (MachineRegisterInfo::use_iterator UI = MRI->use_begin(DstReg),
+       UE = MRI->use_end(); UI != UE; ) {
+    MachineInstr *UseMI = &*UI;
+    unsigned OpNo = UI.getOperandNo();
+    ++UI;
+
+    // LoadAddrHAの使用側: %lo(sym)をアンカーからの差に置き換える
+    if (MI->getOpcode() == AZPR::LoadAddrHA) {
+      UseMI->getOperand(1).setReg(AnchorReg);
+      UseMI->getOperand(2).ChangeToImmediate(Diff);
+      ++NumFolded;
+      continue;
+    }
+
+    if ((UseMI->getOpcode() == AZPR::LDW || UseMI->getOpcode() == AZPR::STW) &&
+        OpNo == 1 && UseMI->getOperand(2).isImm() &&
+        isInt<16>(UseMI->getOperand(2).getImm() + Diff)) {
+      UseMI->getOperand(1).setReg(AnchorReg);
+      UseMI->getOperand(2).setImm(UseMI->getOperand(2).getImm() + Diff);
+      ++NumFolded;
+      continue;
+    }
+    AllFolded = false;
+  }
+
+  if (!AllFolded) {
+    if (Diff == 0)
+      BuildMI(*MI->getParent(), MI, MI->getDebugLoc(),
+              TII->get(TargetOpcode::COPY), DstReg).addReg(AnchorReg);
+    else
+      BuildMI(*MI->getParent(), MI, MI->getDebugLoc(),
+              TII->get(AZPR::ADDUI), DstReg).addReg(AnchorReg).addImm(Diff);
+  }
+
+  // Anchorの生存区間が延びるのでkillフラグは消しておく
+  MRI->clearKillFlags(AnchorReg);
+  MI->eraseFromParent();
+  ++NumAnchored;
+}
+
+bool ConstantAnchor::runOnMachineFunction(MachineFunction &F) {
+  if (DisableConstantAnchor)
+    return false;
+
+  MRI = &F.getRegInfo();
+  MDT = &getAnalysis<MachineDominatorTree>();
+
+  typedef DenseMap<const void*, SmallVector<MachineInstr*, 8> > GroupMap;
+  GroupMap Groups;
+
+  for (MachineFunction::iterator FI = F.begin(), FE = F.end(); FI != FE; ++FI)
+    for (MachineBasicBlock::iterator I = FI->begin(), E = FI->end();
+         I != E; ++I) {
+      const void *Key;
+      int64_t Value;
+      if (getAnchorKey(&*I, Key, Value))
+        Groups[Key].push_back(&*I);
+    }
+
+  bool Changed = false;
+  for (GroupMap::iterator GI = Groups.begin(), GE = Groups.end();
+       GI != GE; ++GI) {
+    SmallVectorImpl<MachineInstr*> &Insts = GI->second;
+    SmallVector<std::pair<MachineInstr*, int64_t>, 8> Anchors;
+
+    for (unsigned i = 0, e = Insts.size(); i != e; ++i) {
+      MachineInstr *MI = Insts[i];
+      const void *Key;
+      int64_t Value;
+      getAnchorKey(MI, Key, Value);
+
+      // MIを支配するアンカーで差が16bitに収まるものを探す
+      MachineInstr *Anchor = 0;
+      int64_t Diff = 0;
+      for (unsigned j = 0, je = Anchors.size(); j != je; ++j) {
+        int64_t D = Value - Anchors[j].second;
+        if (isInt<16>(D) && MDT->dominates(Anchors[j].first, MI)) {
+          Anchor = Anchors[j].first;
+          Diff = D;
+          break;
+        }
+      }
+
+      if (!Anchor) {
+        Anchors.push_back(std::make_pair(MI, Value));
+        continue;
+      }
+
+      DEBUG(dbgs() << "Anchoring: " << *MI << "  on: " << *Anchor);
+      rebaseOnAnchor(MI, Anchor, Diff);
+      Changed = true;
+    }
+  }
+
+  return Changed;
+}
@@ -0,0 +1,228 @@
+//===-- CountDownLoops.cpp - AZPR count-down loop formation ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// AZPR branches compare two registers, so a loop exit test "i < n" keeps both
+// i and n live across the loop. When the induction variable is used only by
+// the exit test, this pass replaces it with a trip counter that is
+// decremented and compared against r0:
+//
+//   c = trip count
+// loop:
+//   ...
+//   c = c - 1
+//   bne c, r0, loop
+//
+// The bound register is freed and the increment and test stay one ADDUI and
+// one branch.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "azpr-count-down-loops"
+#include "AZPR.h"
+#include "llvm/Constants.h"
+#include "llvm/Instructions.h"
+#include "llvm/Pass.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+
+using namespace llvm;
+
+STATISTIC(NumCountDownLoops, "Number of loops converted to count down");
+
+static cl::opt<bool> DisableCountDownLoops(
+  "disable-azpr-count-down-loops",
+  cl::init(false),
+  cl::desc("Disable converting AZPR loops to count down to zero."),
+  cl::Hidden);
+
+namespace {
+  struct CountDownLoops : public FunctionPass {
+    LoopInfo *LI;
+    ScalarEvolution *SE;
+
+    static char ID;
+    CountDownLoops() : FunctionPass(ID) { }
+
+    virtual const char *getPassName() const {
+      return "AZPR Count-Down Loops";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<DominatorTree>();
+      AU.addRequired<LoopInfo>();
+      AU.addRequired<ScalarEvolution>();
+      AU.addPreserved<DominatorTree>();
+      AU.addPreserved<LoopInfo>();
+    }
+
+    bool runOnFunction(Function &F);
+
+  private:
+    bool convertLoop(Loop *L);
+  };
+  char CountDownLoops::ID = 0;
+} // end of anonymous namespace
+
+/// createAZPRCountDownLoopsPass - Returns a pass that rewrites counted loops
+/// to decrement a trip counter and exit when it reaches zero.
+FunctionPass *llvm::createAZPRCountDownLoopsPass() {
+  return new CountDownLoops();
+}
+
+/// containsUDiv - 除算はライブラリ呼び出しになるのでループ前でも作らない.
+/// 2のべき乗での除算はSCEVExpanderが論理右シフトにするのでよい.
+/// LSR後のポインタの誘導変数では回数が(end-start)/4の形になる.
+static bool containsUDiv(const SCEV *S) {
+  if (const SCEVUDivExpr *D = dyn_cast<SCEVUDivExpr>(S)) {
+    const SCEVConstant *RHS = dyn_cast<SCEVConstant>(D->getRHS());
+    if (!RHS || !RHS->getValue()->getValue().isPowerOf2())
+      return true;
+    return containsUDiv(D->getLHS());
+  }
+  if (const SCEVCastExpr *C = dyn_cast<SCEVCastExpr>(S))
+    return containsUDiv(C->getOperand());
+  if (const SCEVNAryExpr *N = dyn_cast<SCEVNAryExpr>(S)) {
+    for (SCEVNAryExpr::op_iterator I = N->op_begin(), E = N->op_end();
+         I != E; ++I)
+      if (containsUDiv(*I))
+        return true;
+  }
+  return false;
+}
+
+static bool isZero(Value *V) {
+  ConstantInt *CI = dyn_cast<ConstantInt>(V);
+  return CI && CI->isZero();
+}
+
+/// onlyUsedBy - Vの使用者がAかBだけか
+static bool onlyUsedBy(Value *V, Value *A, Value *B) {
+  for (Value::use_iterator UI = V->use_begin(), UE = V->use_end();
+       UI != UE; ++UI)
+    if (*UI != A && *UI != B)
+      return false;
+  return true;
+}
+
+/// getExitOnlyIV - 終了判定Cmpだけに使われている誘導変数のPHIを返す
+static PHINode *getExitOnlyIV(Loop *L, ICmpInst *Cmp) {
+  BasicBlock *Latch = L->getLoopLatch();
+  for (BasicBlock::iterator I = L->getHeader()->begin();
+       PHINode *PN = dyn_cast<PHINode>(I); ++I) {
+    Instruction *Inc =
+      dyn_cast<Instruction>(PN->getIncomingValueForBlock(Latch));
+    if (!Inc || Inc == PN)
+      continue;
+    if (Cmp->getOperand(0) != PN && Cmp->getOperand(0) != Inc &&
+        Cmp->getOperand(1) != PN && Cmp->getOperand(1) != Inc)
+      continue;
+    if (onlyUsedBy(PN, Inc, Cmp) && onlyUsedBy(Inc, PN, Cmp))
+      return PN;
+  }
+  return 0;
+}
+
+bool CountDownLoops::convertLoop(Loop *L) {
+  BasicBlock *Preheader = L->getLoopPreheader();
+  BasicBlock *Latch = L->getLoopLatch();
+  if (!Preheader || !Latch || L->getExitingBlock() != Latch)
+    return false;
+
+  BranchInst *BI = dyn_cast<BranchInst>(Latch->getTerminator());
+  if (!BI || !BI->isConditional())
+    return false;
+  ICmpInst *Cmp = dyn_cast<ICmpInst>(BI->getCondition());
+  if (!Cmp || !Cmp->hasOneUse() || Cmp->getParent() != Latch)
+    return false;
+
+  // 既に0との比較ならそのままでよい
+  if (Cmp->isEquality() &&
+      (isZero(Cmp->getOperand(0)) || isZero(Cmp->getOperand(1))))
+    return false;
+
+  PHINode *IV = getExitOnlyIV(L, Cmp);
+  if (!IV)
+    return false;
+
+  const SCEV *BTC = SE->getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BTC) || !BTC->getType()->isIntegerTy() ||
+      SE->getTypeSizeInBits(BTC->getType()) > 32 || containsUDiv(BTC))
+    return false;
+
+  // 回数 = BTC + 1. BTCが0xffffffffなら0になるが, 先に減らして比べるので
+  // 2^32回回ることになり正しい.
+  Type *Int32Ty = Type::getInt32Ty(L->getHeader()->getContext());
+  const SCEV *TripCount =
+    SE->getAddExpr(SE->getNoopOrZeroExtend(BTC, Int32Ty),
+                   SE->getConstant(Int32Ty, 1));
+
+  DEBUG(dbgs() << "Count down: " << *L << "  trip count: " << *TripCount
+               << "\n");
+  SE->forgetLoop(L);
+
+  SCEVExpander Rewriter(*SE, "loopcnt");
+  Value *Init = Rewriter.expandCodeFor(TripCount, Int32Ty,
+                                       Preheader->getTerminator());
+
+  PHINode *Counter = PHINode::Create(Int32Ty, 2, "loopcnt",
+                                     &L->getHeader()->front());
+  Instruction *Dec =
+    BinaryOperator::CreateSub(Counter, ConstantInt::get(Int32Ty, 1),
+                              "loopcnt.dec", BI);
+  for (pred_iterator PI = pred_begin(L->getHeader()),
+       PE = pred_end(L->getHeader()); PI != PE; ++PI)
+    Counter->addIncoming(*PI == Preheader ? Init : Dec, *PI);
+
+  // ループに戻る方向がtrueならne, falseならeq
+  CmpInst::Predicate Pred = L->contains(BI->getSuccessor(0)) ?
+    ICmpInst::ICMP_NE : ICmpInst::ICMP_EQ;
+  ICmpInst *NewCmp = new ICmpInst(BI, Pred, Dec,
+                                  ConstantInt::get(Int32Ty, 0),
+                                  "loopcnt.cmp");
+  BI->setCondition(NewCmp);
+
+  // 元の比較と誘導変数は不要になる
+  Cmp->eraseFromParent();
+  RecursivelyDeleteDeadPHINode(IV);
+
+  ++NumCountDownLoops;
+  return true;
+}
+
+bool CountDownLoops::runOnFunction(Function &F) {
+  if (DisableCountDownLoops)
+    return false;
+
+  LI = &getAnalysis<LoopInfo>();
+  SE = &getAnalysis<ScalarEvolution>();
+
+  // 最内ループだけを対象にする
+  SmallVector<Loop*, 8> Worklist(LI->begin(), LI->end());
+  SmallVector<Loop*, 8> Innermost;
+  while (!Worklist.empty()) {
+    Loop *L = Worklist.pop_back_val();
+    if (L->empty())
+      Innermost.push_back(L);
+    else
+      Worklist.append(L->begin(), L->end());
+  }
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Innermost.size(); i != e; ++i)
+    Changed |= convertLoop(Innermost[i]);
+  return Changed;
+}
@@ -10,6 +10,11 @@
 // This is a simple local pass that attempts to fill delay slots with useful
 // instructions. If no instructions can be moved into the delay slot, then a
 // NOP is placed.
+//
+// A conditional branch that falls through to a block with no other
+// predecessor takes the constant load (ADDUI/ORI/XORI from r0) at the top of
+// that block when the register is dead on the taken path. In a switch
+// lowered to a compare tree this is the next case's constant.
 //===----------------------------------------------------------------------===//
 
 #define DEBUG_TYPE "delay-slot-filler"
@@ -26,6 +31,7 @@
 using namespace llvm;
 
 STATISTIC(FilledSlots, "Number of delay slots filled");
+STATISTIC(UsefulSlots, "Number of delay slots filled with a useful instruction");
 
 static cl::opt<bool> DisableDelaySlotFiller(
   "disable-azpr-delay-filler",
@@ -50,6 +56,8 @@ namespace {
     }
 
     bool runOnMachineBasicBlock(MachineBasicBlock &MBB);
+    MachineInstr *findFallThroughFill(MachineBasicBlock &MBB,
+                                      MachineBasicBlock::iterator Br);
     bool runOnMachineFunction(MachineFunction &F) {
       bool Changed = false;
       for (MachineFunction::iterator FI = F.begin(), FE = F.end();
@@ -82,8 +90,59 @@ bool Filler::runOnMachineBasicBlock(MachineBasicBlock &MBB) {
       ++FilledSlots;
       Changed = true;
 
+      if (MachineInstr *Fill = findFallThroughFill(MBB, I)) {
+        MBB.splice(++J, Fill->getParent(), Fill);
+        ++UsefulSlots;
+        continue;
+      }
+
       BuildMI(MBB, ++J, I->getDebugLoc(), TII->get(AZPR::NOP));
     }
   return Changed;
 }
 
+/// findFallThroughFill - 分岐しなかった側の先頭の定数ロードを遅延スロットに
+/// 移せるならそれを返す. 分岐した側でそのレジスタが生きていてはいけない.
+MachineInstr *Filler::findFallThroughFill(MachineBasicBlock &MBB,
+                                          MachineBasicBlock::iterator Br) {
+  if (DisableDelaySlotFiller || llvm::next(Br) != MBB.end())
+    return 0;
+
+  // 条件分岐だけ. be r0, r0は無条件分岐
+  unsigned Opc = Br->getOpcode();
+  if (Opc != AZPR::BNE && Opc != AZPR::BSGT && Opc != AZPR::BUGT &&
+      (Opc != AZPR::BE ||
+       Br->getOperand(0).getReg() == Br->getOperand(1).getReg()))
+    return 0;
+  MachineBasicBlock *Taken = Br->getOperand(2).getMBB();
+
+  MachineFunction::iterator Next = &MBB;
+  if (++Next == MBB.getParent()->end())
+    return 0;
+  MachineBasicBlock *FallThrough = Next;
+  if (FallThrough == Taken || !MBB.isSuccessor(FallThrough) ||
+      FallThrough->pred_size() != 1)
+    return 0;
+
+  MachineBasicBlock::iterator I = FallThrough->begin();
+  while (I != FallThrough->end() && I->isDebugValue())
+    ++I;
+  if (I == FallThrough->end())
+    return 0;
+
+  // r0からの即値ロード
+  Opc = I->getOpcode();
+  if ((Opc != AZPR::ADDUI && Opc != AZPR::ORI && Opc != AZPR::XORI) ||
+      !I->getOperand(1).isReg() || I->getOperand(1).getReg() != AZPR::r0 ||
+      !I->getOperand(2).isImm())
+    return 0;
+
+  unsigned Reg = I->getOperand(0).getReg();
+  if (Reg == AZPR::r0 || Br->readsRegister(Reg) || Taken->isLiveIn(Reg))
+    return 0;
+
+  // 値は遅延スロットで作られるので, 分岐しなかった側では入口で生きている
+  FallThrough->addLiveIn(Reg);
+  return &*I;
+}
+
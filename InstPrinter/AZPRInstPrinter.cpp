@@ -50,27 +50,86 @@ printOperand(const MCInst *MI, unsigned OpNo, raw_ostream &O) {
   }
 }
 
+/// getSymbolAndAddend - OpがsymまたはSym+addendの式ならsymを返す
+static const MCSymbolRefExpr *getSymbolAndAddend(const MCOperand &Op,
+                                                 int64_t &Addend) {
+  Addend = 0;
+  if (!Op.isExpr())
+    return 0;
+
+  const MCExpr *Expr = Op.getExpr();
+  if (const MCBinaryExpr *BE = dyn_cast<MCBinaryExpr>(Expr))
+    if (BE->getOpcode() == MCBinaryExpr::Add &&
+        isa<MCConstantExpr>(BE->getRHS())) {
+      Expr = BE->getLHS();
+      Addend = cast<MCConstantExpr>(BE->getRHS())->getValue();
+    }
+  return dyn_cast<MCSymbolRefExpr>(Expr);
+}
+
+/// printRelocated - Print "Reloc(sym+addend)" without the variant kind.
+static void printRelocated(const char *Reloc, const MCSymbolRefExpr *SRE,
+                           int64_t Addend, raw_ostream &O) {
+  O << Reloc << "(" << SRE->getSymbol();
+  if (Addend > 0)
+    O << '+';
+  if (Addend)
+    O << Addend;
+  O << ")";
+}
+
 void AZPRInstPrinter::
 printMemOperand(const MCInst *MI, int opNum, raw_ostream &O) {
   DEBUG(dbgs() << ">>> printMemOperand:"; MI->dump());
-  printOperand(MI, opNum+1, O);
+  int64_t Addend;
+  const MCSymbolRefExpr *SRE =
+    getSymbolAndAddend(MI->getOperand(opNum+1), Addend);
+
+  // グローバル変数の下位16bitはlow(sym), gpからのオフセットはgp_rel(sym),
+  // スモールコードモデルのアドレスはabs(sym)
+  if (SRE && SRE->getKind() == MCSymbolRefExpr::VK_Mips_ABS_LO)
+    printRelocated("low", SRE, Addend, O);
+  else if (SRE && SRE->getKind() == MCSymbolRefExpr::VK_Mips_GPREL)
+    printRelocated("gp_rel", SRE, Addend, O);
+  else if (SRE && SRE->getKind() == MCSymbolRefExpr::VK_None)
+    printRelocated("abs", SRE, Addend, O);
+  else
+    printOperand(MI, opNum+1, O);
   O << "(";
   printOperand(MI, opNum, O);
   O << ")";
 }
 
 void AZPRInstPrinter::
-printAbsAddrHI16(const MCInst *MI, int opNum, raw_ostream &O) {
-  DEBUG(dbgs() << ">>> printAbsAddrHI16:"; MI->dump());
-  O << "high(";
+printAbsAddrLO16(const MCInst *MI, int opNum, raw_ostream &O) {
+  DEBUG(dbgs() << ">>> printAbsAddrLO16:"; MI->dump());
+  O << "low(";
   printOperand(MI, opNum, O);
   O << ")";
 }
 
 void AZPRInstPrinter::
-printAbsAddrLO16(const MCInst *MI, int opNum, raw_ostream &O) {
-  DEBUG(dbgs() << ">>> printAbsAddrLO16:"; MI->dump());
-  O << "low(";
+printAbsAddrHA16(const MCInst *MI, int opNum, raw_ostream &O) {
+  DEBUG(dbgs() << ">>> printAbsAddrHA16:"; MI->dump());
+  O << "high_a(";
+  printOperand(MI, opNum, O);
+  O << ")";
+}
+
+void AZPRInstPrinter::
+printGPRel16(const MCInst *MI, int opNum, raw_ostream &O) {
+  DEBUG(dbgs() << ">>> printGPRel16:"; MI->dump());
+  int64_t Addend;
+  const MCSymbolRefExpr *SRE = getSymbolAndAddend(MI->getOperand(opNum),
+                                                  Addend);
+  assert(SRE && "printGPRel16 expects a symbol");
+  printRelocated("gp_rel", SRE, Addend, O);
+}
+
+void AZPRInstPrinter::
+printAbsAddr16(const MCInst *MI, int opNum, raw_ostream &O) {
+  DEBUG(dbgs() << ">>> printAbsAddr16:"; MI->dump());
+  O << "abs(";
   printOperand(MI, opNum, O);
   O << ")";
 }
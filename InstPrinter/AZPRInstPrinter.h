@@ -40,8 +40,10 @@ private:
   // used in printInstruction
   void printOperand(const MCInst *MI, unsigned OpNo, raw_ostream &O);
   void printMemOperand(const MCInst *MI, int opNum, raw_ostream &O);
-  void printAbsAddrHI16(const MCInst *MI, int opNum, raw_ostream &O);
   void printAbsAddrLO16(const MCInst *MI, int opNum, raw_ostream &O);
+  void printAbsAddrHA16(const MCInst *MI, int opNum, raw_ostream &O);
+  void printGPRel16(const MCInst *MI, int opNum, raw_ostream &O);
+  void printAbsAddr16(const MCInst *MI, int opNum, raw_ostream &O);
 };
 } // end namespace llvm
 
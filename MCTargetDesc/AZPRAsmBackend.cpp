@@ -25,6 +25,7 @@
 #include "llvm/Support/Debug.h" 
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace llvm;
 
@@ -36,13 +37,27 @@ static unsigned adjustFixupValue(unsigned Kind, uint64_t Value) {
   default:
     return 0;
   case AZPR::fixup_AZPR_HI16:
+    // oriで下位16bitを足すのでそのまま
     Value = (Value >> 16) & 0xffff;
     break;
+  case AZPR::fixup_AZPR_HA16:
+    // 下位16bitはaddui/ldw/stwで符号拡張して足されるので, その分を上位に
+    // 繰り上げる. リンカがR_MIPS_HI16を解決するときと同じ計算
+    Value = ((Value + 0x8000) >> 16) & 0xffff;
+    break;
   case AZPR::fixup_AZPR_LO16:
     break;
   case AZPR::fixup_AZPR_PC16:
     Value = (Value - 4) >> 2;
     break;
+  case AZPR::fixup_AZPR_GPREL16:
+    break;
+  case AZPR::fixup_AZPR_ABS16:
+    // adduiで作るので符号付き16bit
+    if (!isInt<16>((int32_t)Value))
+      report_fatal_error("symbol address out of range for the small code "
+                         "model");
+    break;
   case FK_Data_4:
     break;
   }
@@ -165,7 +180,10 @@ getFixupKindInfo(MCFixupKind Kind) const {
     // name                  offset    bits  flags
     {"fixup_AZPR_HI16",         0,     16,     0},
     {"fixup_AZPR_LO16",         0,     16,     0},
-    {"fixup_AZPR_PC16",         0,     16,     MCFixupKindInfo::FKF_IsPCRel}
+    {"fixup_AZPR_PC16",         0,     16,     MCFixupKindInfo::FKF_IsPCRel},
+    {"fixup_AZPR_HA16",         0,     16,     0},
+    {"fixup_AZPR_GPREL16",      0,     16,     0},
+    {"fixup_AZPR_ABS16",        0,     16,     0}
   };
 
   if (Kind < FirstTargetFixupKind)
@@ -12,7 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 #ifndef SAMPLEBASEINFO_H
-#define SAMPLEASEINFO_H
+#define SAMPLEBASEINFO_H
 
 //#include "AZPRFixupKinds.h"
 #include "AZPRMCTargetDesc.h"
@@ -22,6 +22,26 @@
 
 namespace llvm {
 
+/// AZPRII - This namespace holds all of the target specific flags that
+/// instruction info tracks.
+namespace AZPRII {
+  /// Target Operand Flag enum.
+  enum TOF {
+    MO_NO_FLAG,
+
+    /// MO_CPREL - Offset of a constant pool entry from the function's
+    /// constant pool base, used as the LDW offset.
+    MO_CPREL,
+
+    /// MO_ABS_LO - Low 16 bits of a global's address, used as the LDW/STW
+    /// offset on top of a base made with the adjusted high half.
+    MO_ABS_LO,
+
+    /// MO_GPREL - Offset of a small data object from the global pointer.
+    MO_GPREL
+  };
+}
+
 /// getAZPRRegisterNumbering - Given the enum value for some register,
 /// return the number that it corresponds to.
 inline static unsigned getAZPRRegisterNumbering(unsigned RegEnum)
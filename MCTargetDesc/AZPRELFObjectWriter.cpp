@@ -16,6 +16,7 @@
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include <list>
 
 using namespace llvm;
@@ -72,6 +73,12 @@ GetRelocType(const MCValue &Target,
   default:
     llvm_unreachable("invalid fixup kind!");
   case AZPR::fixup_AZPR_HI16:
+    // R_MIPS_HI16はリンカが下位の符号拡張分を繰り上げるので, oriと組む
+    // 繰り上げないhighは表せない
+    report_fatal_error("high() cannot be relocated, use high_a() paired "
+                       "with addui, ldw or stw");
+  case AZPR::fixup_AZPR_HA16:
+    // R_MIPS_HI16は対になるR_MIPS_LO16の符号拡張を考慮して計算される
     Type = ELF::R_MIPS_HI16;
     break;
   case AZPR::fixup_AZPR_LO16:
@@ -80,6 +87,17 @@ GetRelocType(const MCValue &Target,
   case AZPR::fixup_AZPR_PC16:
     Type = ELF::R_MIPS_PC16;
     break;
+  case AZPR::fixup_AZPR_GPREL16:
+    Type = ELF::R_MIPS_GPREL16;
+    break;
+  case AZPR::fixup_AZPR_ABS16:
+    // R_MIPS_16はリンカが符号付き16bitに収まるか検査する.
+    // 加数だけで範囲を越えていればここで分かる
+    if (!isInt<16>((int32_t)Target.getConstant()))
+      report_fatal_error("symbol offset out of range for the small code "
+                         "model");
+    Type = ELF::R_MIPS_16;
+    break;
   case FK_Data_4://関数のアドレスを配列に保存するため
     Type = ELF::R_MIPS_32;
     break;
@@ -23,9 +23,17 @@ namespace AZPR {
   // in AZPRAsmBackend.cpp.
   //
   enum Fixups {
+    // そのままの上位16bit(high). 下位はoriで足す
     fixup_AZPR_HI16 = FirstTargetFixupKind,
     fixup_AZPR_LO16,
     fixup_AZPR_PC16,
+    // 下位16bitを符号拡張して足すことを見越した上位16bit(high_a).
+    // 下位はaddui, ldw, stwで足す
+    fixup_AZPR_HA16,
+    // gpからの符号付き16bitオフセット
+    fixup_AZPR_GPREL16,
+    // スモールコードモデルの16bit絶対アドレス(符号拡張)
+    fixup_AZPR_ABS16,
     LastTargetFixupKind,
     NumTargetFixupKinds = LastTargetFixupKind - FirstTargetFixupKind
   };
@@ -82,12 +82,18 @@ class AZPRMCCodeEmitter : public MCCodeEmitter {
   unsigned getCallTargetOpValue(const MCInst &MI, unsigned OpNo,
                                 SmallVectorImpl<MCFixup> &Fixups) const;
 
-  unsigned getAbsAddrHI16(const MCInst &MI, unsigned OpNo,
+  unsigned getAbsAddrLO16(const MCInst &MI, unsigned OpNo,
                                 SmallVectorImpl<MCFixup> &Fixups) const;
 
-  unsigned getAbsAddrLO16(const MCInst &MI, unsigned OpNo,
+  unsigned getAbsAddrHA16(const MCInst &MI, unsigned OpNo,
                                 SmallVectorImpl<MCFixup> &Fixups) const;
 
+  unsigned getGPRelEncoding(const MCInst &MI, unsigned OpNo,
+                            SmallVectorImpl<MCFixup> &Fixups) const;
+
+  unsigned getAbsAddr16(const MCInst &MI, unsigned OpNo,
+                        SmallVectorImpl<MCFixup> &Fixups) const;
+
 }; // class AZPRMCCodeEmitter
 }  // namespace
 
@@ -135,22 +141,45 @@ getMachineOpValue(const MCInst &MI, const MCOperand &MO,
   assert(MO.isExpr());
 
   const MCExpr *Expr = MO.getExpr();
-  MCExpr::ExprKind Kind = Expr->getKind();
 
-  assert (Kind == MCExpr::SymbolRef);
+  // sym+offsetはsymの種類(low, gp_relなど)で決める
+  const MCExpr *SymExpr = Expr;
+  if (const MCBinaryExpr *BE = dyn_cast<MCBinaryExpr>(Expr))
+    if (BE->getOpcode() == MCBinaryExpr::Add &&
+        isa<MCSymbolRefExpr>(BE->getLHS()))
+      SymExpr = BE->getLHS();
+
+  // コンスタントプールのベースからの差(同じセクション内なので定数に解決される)
+  if (SymExpr->getKind() == MCExpr::Binary) {
+    Fixups.push_back(MCFixup::Create(0, Expr,
+                                     MCFixupKind(AZPR::fixup_AZPR_LO16)));
+    return 0;
+  }
+
+  assert (SymExpr->getKind() == MCExpr::SymbolRef);
 
   AZPR::Fixups FixupKind = AZPR::Fixups(0);
 
 //デバッグ用。使わない。
-  MCSymbolRefExpr::VariantKind vk = cast<MCSymbolRefExpr>(Expr)->getKind();
+  MCSymbolRefExpr::VariantKind vk = cast<MCSymbolRefExpr>(SymExpr)->getKind();
 
-  switch(cast<MCSymbolRefExpr>(Expr)->getKind()) {
+  switch(cast<MCSymbolRefExpr>(SymExpr)->getKind()) {
+  case MCSymbolRefExpr::VK_None:
+    // スモールコードモデルでr0からのldw/stwのオフセットにしたアドレス
+    FixupKind = AZPR::fixup_AZPR_ABS16;
+    break;
   case MCSymbolRefExpr::VK_Mips_ABS_HI:
     FixupKind = AZPR::fixup_AZPR_HI16;
     break;
+  case MCSymbolRefExpr::VK_PPC_GAS_HA16:
+    FixupKind = AZPR::fixup_AZPR_HA16;
+    break;
   case MCSymbolRefExpr::VK_Mips_ABS_LO:
     FixupKind = AZPR::fixup_AZPR_LO16;
     break;
+  case MCSymbolRefExpr::VK_Mips_GPREL:
+    FixupKind = AZPR::fixup_AZPR_GPREL16;
+    break;
   case MCSymbolRefExpr::VK_Mips_LO16 + 100:
     FixupKind = AZPR::fixup_AZPR_PC16;
     break;
@@ -250,32 +279,61 @@ getCallTargetOpValue(const MCInst &MI, unsigned OpNo,
   return 0;
 }
 */
-/// getJumpTargetOpValue - Return binary encoding of the jump
-/// target operand. If the machine operand requires relocation,
-/// record the relocation and return zero.
 unsigned AZPRMCCodeEmitter::
-getAbsAddrHI16(const MCInst &MI, unsigned OpNo,
+getAbsAddrLO16(const MCInst &MI, unsigned OpNo,
                      SmallVectorImpl<MCFixup> &Fixups) const {
 
   const MCOperand &MO = MI.getOperand(OpNo);
-  assert(MO.isExpr() && "getCallTargetOpValueHI16 expects only expressions");
+  assert(MO.isExpr() && "getCallTargetOpValueLO16 expects only expressions");
 
   const MCExpr *Expr = MO.getExpr();
-  Fixups.push_back(MCFixup::Create(/*Offset*/0, Expr,
-                                   MCFixupKind(AZPR::fixup_AZPR_HI16)));
+  Fixups.push_back(MCFixup::Create(0, Expr,
+                                   MCFixupKind(AZPR::fixup_AZPR_LO16)));
   return 0;
 }
 
+/// getAbsAddrHA16 - Return binary encoding of the high half of an address
+/// whose low half is used as a sign-extended load/store offset.
 unsigned AZPRMCCodeEmitter::
-getAbsAddrLO16(const MCInst &MI, unsigned OpNo,
+getAbsAddrHA16(const MCInst &MI, unsigned OpNo,
                      SmallVectorImpl<MCFixup> &Fixups) const {
 
   const MCOperand &MO = MI.getOperand(OpNo);
-  assert(MO.isExpr() && "getCallTargetOpValueLO16 expects only expressions");
+  assert(MO.isExpr() && "getAbsAddrHA16 expects only expressions");
 
   const MCExpr *Expr = MO.getExpr();
   Fixups.push_back(MCFixup::Create(0, Expr,
-                                   MCFixupKind(AZPR::fixup_AZPR_LO16)));
+                                   MCFixupKind(AZPR::fixup_AZPR_HA16)));
+  return 0;
+}
+
+/// getGPRelEncoding - Return binary encoding of a small data object's offset
+/// from the global pointer.
+unsigned AZPRMCCodeEmitter::
+getGPRelEncoding(const MCInst &MI, unsigned OpNo,
+                 SmallVectorImpl<MCFixup> &Fixups) const {
+
+  const MCOperand &MO = MI.getOperand(OpNo);
+  assert(MO.isExpr() && "getGPRelEncoding expects only expressions");
+
+  const MCExpr *Expr = MO.getExpr();
+  Fixups.push_back(MCFixup::Create(0, Expr,
+                                   MCFixupKind(AZPR::fixup_AZPR_GPREL16)));
+  return 0;
+}
+
+/// getAbsAddr16 - Return binary encoding of a whole address under the small
+/// code model.
+unsigned AZPRMCCodeEmitter::
+getAbsAddr16(const MCInst &MI, unsigned OpNo,
+             SmallVectorImpl<MCFixup> &Fixups) const {
+
+  const MCOperand &MO = MI.getOperand(OpNo);
+  assert(MO.isExpr() && "getAbsAddr16 expects only expressions");
+
+  const MCExpr *Expr = MO.getExpr();
+  Fixups.push_back(MCFixup::Create(0, Expr,
+                                   MCFixupKind(AZPR::fixup_AZPR_ABS16)));
   return 0;
 }
 
@@ -0,0 +1,127 @@
+//===-- RuntimeUnroll.cpp - AZPR runtime loop unrolling -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// LoopUnroll only unrolls loops whose trip count is unknown when the global
+// -unroll-runtime flag is given, and this LLVM has no way for a target to set
+// it. This pass unrolls such innermost loops by a power of two, with a prolog
+// that runs the remaining (trip count & (Count - 1)) iterations first:
+//
+// prolog:
+//   ...                    ; 0 .. Count-1 iterations
+// loop:
+//   ... x Count
+//   bne ..., loop
+//
+// The remainder is an AND, so no division libcall is needed. Loops with a
+// compile-time trip count are left to LoopUnroll.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "azpr-runtime-unroll"
+#include "AZPR.h"
+#include "llvm/DataLayout.h"
+#include "llvm/Pass.h"
+#include "llvm/Analysis/CodeMetrics.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/UnrollLoop.h"
+#include "llvm/ADT/Statistic.h"
+#include <algorithm>
+
+using namespace llvm;
+
+STATISTIC(NumRuntimeUnrolled, "Number of loops unrolled with a runtime prolog");
+
+static cl::opt<bool> DisableRuntimeUnroll(
+  "disable-azpr-runtime-unroll",
+  cl::init(false),
+  cl::desc("Disable AZPR unrolling of loops with a runtime trip count."),
+  cl::Hidden);
+
+static cl::opt<unsigned> RuntimeUnrollCount(
+  "azpr-unroll-runtime-count",
+  cl::init(4),
+  cl::desc("Unroll count of AZPR loops with a runtime trip count."),
+  cl::Hidden);
+
+namespace {
+  struct RuntimeUnroll : public LoopPass {
+    unsigned Threshold;
+
+    static char ID;
+    RuntimeUnroll(unsigned T) : LoopPass(ID), Threshold(T) { }
+
+    virtual const char *getPassName() const {
+      return "AZPR Runtime Loop Unrolling";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<LoopInfo>();
+      AU.addPreserved<LoopInfo>();
+      AU.addRequiredID(LoopSimplifyID);
+      AU.addPreservedID(LoopSimplifyID);
+      AU.addRequiredID(LCSSAID);
+      AU.addPreservedID(LCSSAID);
+      AU.addRequired<ScalarEvolution>();
+      AU.addPreserved<ScalarEvolution>();
+    }
+
+    bool runOnLoop(Loop *L, LPPassManager &LPM);
+  };
+  char RuntimeUnroll::ID = 0;
+} // end of anonymous namespace
+
+/// createAZPRRuntimeUnrollPass - Returns a pass that unrolls innermost loops
+/// with a runtime trip count while the body stays under Threshold.
+Pass *llvm::createAZPRRuntimeUnrollPass(unsigned Threshold) {
+  return new RuntimeUnroll(Threshold);
+}
+
+bool RuntimeUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
+  if (DisableRuntimeUnroll || RuntimeUnrollCount < 2 || !L->empty())
+    return false;
+
+  BasicBlock *Latch = L->getLoopLatch();
+  if (!Latch || !L->getLoopPreheader())
+    return false;
+
+  // 回数が分かるループはLoopUnrollに任せる
+  ScalarEvolution *SE = &getAnalysis<ScalarEvolution>();
+  if (SE->getSmallConstantTripCount(L, Latch))
+    return false;
+
+  CodeMetrics Metrics;
+  const DataLayout *TD = getAnalysisIfAvailable<DataLayout>();
+  for (Loop::block_iterator I = L->block_begin(), E = L->block_end();
+       I != E; ++I)
+    Metrics.analyzeBasicBlock(*I, TD);
+  if (Metrics.NumInlineCandidates || Metrics.containsIndirectBr)
+    return false;
+
+  // 剰余をandで求めるので2のべき乗にする
+  unsigned Count = RuntimeUnrollCount;
+  while (Count & (Count - 1))
+    Count &= Count - 1;
+  unsigned Size = std::max(Metrics.NumInsts, 3u);
+  while (Count > 1 && Size * Count > Threshold)
+    Count >>= 1;
+  if (Count < 2)
+    return false;
+
+  LoopInfo *LI = &getAnalysis<LoopInfo>();
+  if (!UnrollLoop(L, Count, /*TripCount*/ 0, /*AllowRuntime*/ true,
+                  /*TripMultiple*/ 1, LI, &LPM))
+    return false;
+
+  ++NumRuntimeUnrolled;
+  return true;
+}
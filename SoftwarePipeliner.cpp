@@ -0,0 +1,329 @@
+//===-- SoftwarePipeliner.cpp - AZPR load software pipelining -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A load result on AZPR is available one cycle later than an ALU result, so a
+// single-block loop that uses each loaded value right away stalls on every
+// LDW. This pass pipelines such loops by one stage: the loads of iteration
+// i+1 are issued at the top of iteration i and their values are carried to
+// the next iteration in PHIs.
+//
+//   preheader:  v = load p[0]                   (prologue)
+//               if (btc == 0) goto epilogue
+//   kernel:     cur = phi(v, next)
+//               next = load p[i+1]
+//               ... body using cur ...
+//               if (--cnt != 0) goto kernel
+//   epilogue:   ... body of the last iteration using the last loaded value
+//
+// The kernel runs backedge-taken-count times, so no load is issued beyond the
+// last iteration. Only read-only loops are handled, and the number of values
+// kept live across iterations is limited to keep register pressure low.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "azpr-software-pipeliner"
+#include "AZPR.h"
+#include "llvm/Constants.h"
+#include "llvm/Instructions.h"
+#include "llvm/Pass.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/MC/MCInstrItineraries.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ValueHandle.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+
+using namespace llvm;
+
+STATISTIC(NumPipelinedLoops, "Number of loops software pipelined");
+STATISTIC(NumPipelinedLoads, "Number of loads issued one iteration ahead");
+
+static cl::opt<bool> DisableSoftwarePipelining(
+  "disable-azpr-software-pipelining",
+  cl::init(false),
+  cl::desc("Disable AZPR software pipelining of loads."),
+  cl::Hidden);
+
+static cl::opt<unsigned> MaxPipelinedLoads(
+  "azpr-swp-max-loads",
+  cl::init(4),
+  cl::desc("Maximum number of loads issued ahead in one loop."),
+  cl::Hidden);
+
+static cl::opt<unsigned> MaxLiveValues(
+  "azpr-swp-max-live",
+  cl::init(16),
+  cl::desc("Maximum number of values live across a pipelined iteration."),
+  cl::Hidden);
+
+namespace {
+  struct SoftwarePipeliner : public FunctionPass {
+    TargetMachine &TM;
+    LoopInfo *LI;
+    ScalarEvolution *SE;
+
+    static char ID;
+    SoftwarePipeliner(TargetMachine &tm) : FunctionPass(ID), TM(tm) { }
+
+    virtual const char *getPassName() const {
+      return "AZPR Software Pipeliner";
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<LoopInfo>();
+      AU.addRequired<ScalarEvolution>();
+      AU.addPreserved<LoopInfo>();
+    }
+
+    bool runOnFunction(Function &F);
+
+  private:
+    unsigned getLoadLatency() const;
+    bool pipelineLoop(Loop *L);
+  };
+  char SoftwarePipeliner::ID = 0;
+} // end of anonymous namespace
+
+/// createAZPRSoftwarePipelinerPass - Returns a pass that issues the loads of
+/// the next iteration of single-block loops ahead of the current one.
+FunctionPass *llvm::createAZPRSoftwarePipelinerPass(TargetMachine &tm) {
+  return new SoftwarePipeliner(tm);
+}
+
+/// getLoadLatency - LDWの結果が使えるまでのサイクル数(命令スケジューリングの
+/// itineraryから)
+unsigned SoftwarePipeliner::getLoadLatency() const {
+  const InstrItineraryData *ItinData = TM.getInstrItineraryData();
+  if (!ItinData || ItinData->isEmpty())
+    return 1;
+
+  unsigned SchedClass = TM.getInstrInfo()->get(AZPR::LDW).getSchedClass();
+  int Cycle = ItinData->getOperandCycle(SchedClass, 0);
+  return Cycle > 0 ? Cycle : 1;
+}
+
+bool SoftwarePipeliner::pipelineLoop(Loop *L) {
+  BasicBlock *Body = L->getHeader();
+  BasicBlock *Preheader = L->getLoopPreheader();
+  BasicBlock *Exit = L->getExitBlock();
+  if (L->getNumBlocks() != 1 || !Preheader || !Exit ||
+      Exit->getSinglePredecessor() != Body)
+    return false;
+
+  BranchInst *BI = dyn_cast<BranchInst>(Body->getTerminator());
+  BranchInst *PreBr = dyn_cast<BranchInst>(Preheader->getTerminator());
+  if (!BI || !BI->isConditional() || !PreBr || PreBr->isConditional())
+    return false;
+
+  // ロードを1つ前の繰り返しに移すので, メモリに書く命令があってはいけない
+  SmallVector<LoadInst*, 4> Loads;
+  SmallVector<const SCEVAddRecExpr*, 4> Addrs;
+  unsigned NumPHIs = 0;
+  for (BasicBlock::iterator I = Body->begin(), E = Body->end(); I != E; ++I) {
+    if (isa<PHINode>(I)) {
+      ++NumPHIs;
+      continue;
+    }
+    if (LoadInst *LD = dyn_cast<LoadInst>(I)) {
+      if (!LD->isSimple())
+        return false;
+      const SCEVAddRecExpr *AR =
+        dyn_cast<SCEVAddRecExpr>(SE->getSCEV(LD->getPointerOperand()));
+      if (AR && AR->getLoop() == L && AR->isAffine() &&
+          isa<SCEVConstant>(AR->getStepRecurrence(*SE)) &&
+          Loads.size() < MaxPipelinedLoads) {
+        Loads.push_back(LD);
+        Addrs.push_back(AR);
+      }
+      continue;
+    }
+    if (I->mayWriteToMemory() || I->mayThrow())
+      return false;
+  }
+  if (Loads.empty())
+    return false;
+
+  // 繰り返しをまたいで生きる値: 元のPHI, 先読みした値, カウンタ
+  if (NumPHIs + Loads.size() + 1 > MaxLiveValues)
+    return false;
+
+  const SCEV *BTC = SE->getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BTC) || !BTC->getType()->isIntegerTy() ||
+      SE->getTypeSizeInBits(BTC->getType()) > 32 || BTC->isZero())
+    return false;
+
+  DEBUG(dbgs() << "Pipelining " << Loads.size() << " loads in " << *L);
+  SE->forgetLoop(L);
+
+  // エピローグ: 最後の繰り返しの本体. PHIは前の繰り返しの値をそのまま受ける
+  // (前任はプリヘッダとカーネル)ので書き換えない.
+  ValueToValueMapTy VMap;
+  BasicBlock *Epilog = CloneBasicBlock(Body, VMap, ".epil",
+                                       Body->getParent());
+  Epilog->moveAfter(Body);
+  for (BasicBlock::iterator I = Epilog->begin(), E = Epilog->end();
+       I != E; ++I)
+    if (!isa<PHINode>(I))
+      RemapInstruction(I, VMap, RF_IgnoreMissingEntries);
+  Epilog->getTerminator()->eraseFromParent();
+  BranchInst::Create(Exit, Epilog);
+
+  SmallVector<PHINode*, 4> EpilogVals;
+  for (unsigned i = 0, e = Loads.size(); i != e; ++i) {
+    LoadInst *Clone = cast<LoadInst>(VMap[Loads[i]]);
+    PHINode *PN = PHINode::Create(Clone->getType(), 2,
+                                  Loads[i]->getName() + ".epil",
+                                  &Epilog->front());
+    Clone->replaceAllUsesWith(PN);
+    Clone->eraseFromParent();
+    VMap[Loads[i]] = PN;
+    EpilogVals.push_back(PN);
+  }
+
+  // ループの外の使用はエピローグの値にする
+  for (BasicBlock::iterator I = Body->begin(), E = Body->end(); I != E; ++I) {
+    SmallVector<Use*, 4> Outside;
+    for (Value::use_iterator UI = I->use_begin(), UE = I->use_end();
+         UI != UE; ++UI) {
+      BasicBlock *UseBB = cast<Instruction>(*UI)->getParent();
+      if (UseBB != Body && UseBB != Epilog)
+        Outside.push_back(&UI.getUse());
+    }
+    for (unsigned i = 0, e = Outside.size(); i != e; ++i)
+      Outside[i]->set(VMap[I]);
+  }
+  for (BasicBlock::iterator I = Exit->begin();
+       PHINode *PN = dyn_cast<PHINode>(I); ++I)
+    PN->setIncomingBlock(PN->getBasicBlockIndex(Body), Epilog);
+
+  // プロローグで最初の繰り返しのロード, カーネルの先頭で次の繰り返しのロード.
+  // ループ内ではSCEVExpanderを使わない. 正規の誘導変数を新しく作って
+  // アドレスをstart+iv*strideで作り直してしまう(strideが2のべき乗でなければ
+  // 乗算のライブラリ呼び出しになる).
+  SCEVExpander Rewriter(*SE, "swp");
+  Rewriter.disableCanonicalMode();
+  Instruction *InsertPt = Body->getFirstNonPHI();
+  for (unsigned i = 0, e = Loads.size(); i != e; ++i) {
+    LoadInst *LD = Loads[i];
+    Value *Ptr = LD->getPointerOperand();
+    Type *PtrTy = Ptr->getType();
+
+    Value *Start = Rewriter.expandCodeFor(Addrs[i]->getStart(), PtrTy, PreBr);
+    LoadInst *First = new LoadInst(Start, LD->getName() + ".pro", false,
+                                   LD->getAlignment(), PreBr);
+
+    // 次の繰り返しのアドレスはロード自身のアドレスに1回分の増分を足したもの.
+    // 定数なのでldwのオフセットに入る
+    Instruction *At = InsertPt;
+    if (Instruction *PtrI = dyn_cast<Instruction>(Ptr))
+      if (PtrI->getParent() == Body && !isa<PHINode>(PtrI))
+        At = llvm::next(BasicBlock::iterator(PtrI));
+    const SCEVConstant *Step =
+      cast<SCEVConstant>(Addrs[i]->getStepRecurrence(*SE));
+    Type *Int8PtrTy =
+      Type::getInt8PtrTy(Body->getContext(),
+                         cast<PointerType>(PtrTy)->getAddressSpace());
+    Value *NextPtr = new BitCastInst(Ptr, Int8PtrTy, "", At);
+    NextPtr = GetElementPtrInst::Create(NextPtr, Step->getValue(),
+                                        LD->getName() + ".next.ptr", At);
+    NextPtr = new BitCastInst(NextPtr, PtrTy, "", At);
+    LoadInst *Next = new LoadInst(NextPtr, LD->getName() + ".next", false,
+                                  LD->getAlignment(), At);
+
+    PHINode *Cur = PHINode::Create(LD->getType(), 2, LD->getName() + ".cur",
+                                   &Body->front());
+    Cur->addIncoming(First, Preheader);
+    Cur->addIncoming(Next, Body);
+    EpilogVals[i]->addIncoming(First, Preheader);
+    EpilogVals[i]->addIncoming(Next, Body);
+
+    LD->replaceAllUsesWith(Cur);
+    LD->eraseFromParent();
+    ++NumPipelinedLoads;
+  }
+
+  // カーネルはBTC回まわす
+  Type *CntTy = Type::getInt32Ty(Body->getContext());
+  Value *Count = Rewriter.expandCodeFor(SE->getNoopOrZeroExtend(BTC, CntTy),
+                                        CntTy, PreBr);
+  PHINode *Cnt = PHINode::Create(CntTy, 2, "swp.cnt", &Body->front());
+  Instruction *Dec = BinaryOperator::CreateSub(Cnt, ConstantInt::get(CntTy, 1),
+                                               "swp.dec", BI);
+  Cnt->addIncoming(Count, Preheader);
+  Cnt->addIncoming(Dec, Body);
+  Value *More = new ICmpInst(BI, ICmpInst::ICMP_NE, Dec,
+                             ConstantInt::get(CntTy, 0), "swp.more");
+  Value *OldCond = BI->getCondition();
+  BranchInst::Create(Body, Epilog, More, BI);
+  BI->eraseFromParent();
+  RecursivelyDeleteTriviallyDeadInstructions(OldCond);
+
+  // BTCが0ならカーネルを飛ばす. 定数なら分岐は不要
+  if (isa<SCEVConstant>(BTC)) {
+    for (BasicBlock::iterator I = Epilog->begin();
+         PHINode *PN = dyn_cast<PHINode>(I); ++I)
+      PN->removeIncomingValue(Preheader, false);
+  } else {
+    Value *Skip = new ICmpInst(PreBr, ICmpInst::ICMP_EQ, Count,
+                               ConstantInt::get(CntTy, 0), "swp.skip");
+    BranchInst::Create(Epilog, Body, Skip, PreBr);
+    PreBr->eraseFromParent();
+  }
+
+  // 元の誘導変数のうち終了判定だけに使われていたものと, エピローグに
+  // 複製したアドレス計算は使われないので消す
+  SmallVector<WeakVH, 8> PHIs;
+  for (BasicBlock::iterator I = Body->begin();
+       PHINode *PN = dyn_cast<PHINode>(I); ++I)
+    PHIs.push_back(PN);
+  for (unsigned i = 0, e = PHIs.size(); i != e; ++i)
+    if (PHINode *PN = dyn_cast_or_null<PHINode>(PHIs[i]))
+      RecursivelyDeleteDeadPHINode(PN);
+  SimplifyInstructionsInBlock(Epilog);
+
+  if (Loop *Parent = L->getParentLoop())
+    Parent->addBasicBlockToLoop(Epilog, LI->getBase());
+
+  ++NumPipelinedLoops;
+  return true;
+}
+
+bool SoftwarePipeliner::runOnFunction(Function &F) {
+  // ロードの結果をすぐに使っても止まらないなら何もしない
+  if (DisableSoftwarePipelining || getLoadLatency() <= 1)
+    return false;
+
+  LI = &getAnalysis<LoopInfo>();
+  SE = &getAnalysis<ScalarEvolution>();
+
+  // 最内ループだけを対象にする
+  SmallVector<Loop*, 8> Worklist(LI->begin(), LI->end());
+  SmallVector<Loop*, 8> Innermost;
+  while (!Worklist.empty()) {
+    Loop *L = Worklist.pop_back_val();
+    if (L->empty())
+      Innermost.push_back(L);
+    else
+      Worklist.append(L->begin(), L->end());
+  }
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Innermost.size(); i != e; ++i)
+    Changed |= pipelineLoop(Innermost[i]);
+  return Changed;
+}
@@ -0,0 +1,52 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+; RUN: llc -march=azpr -azpr-jump-is-expensive < %s \
+; RUN:   | FileCheck %s -check-prefix=EXPENSIVE
+
+; Two equality tests used as a value become one test of (a^b)|(c^d).
+
+define i32 @both_eq(i32 %a, i32 %b, i32 %c, i32 %d) nounwind readnone {
+entry:
+  %x = icmp eq i32 %a, %b
+  %y = icmp eq i32 %c, %d
+  %z = and i1 %x, %y
+  %r = zext i1 %z to i32
+  ret i32 %r
+}
+
+; CHECK: both_eq:
+; CHECK: xorr
+; CHECK: xorr
+; CHECK: orr
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-NOT: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: .size both_eq
+
+; && of two signed comparisons is a branch chain by default. With
+; expensive jumps it is one branch on the combined value.
+
+define void @both_lt(i32 %a, i32 %b, i32 %c, i32 %d, i32* %p) nounwind {
+entry:
+  %x = icmp slt i32 %a, %b
+  %y = icmp slt i32 %c, %d
+  %z = and i1 %x, %y
+  br i1 %z, label %then, label %exit
+
+then:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: both_lt:
+; CHECK: bsgt
+; CHECK: bsgt
+; CHECK: .size both_lt
+
+; EXPENSIVE: both_lt:
+; EXPENSIVE: andr
+; EXPENSIVE-NOT: bsgt
+; EXPENSIVE: {{be|bne}} r0,
+; EXPENSIVE-NOT: bsgt
+; EXPENSIVE: .size both_lt
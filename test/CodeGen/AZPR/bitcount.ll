@@ -0,0 +1,82 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Bit counts are inline shift-and-mask sequences. With optsize, ctpop and
+; cttz call __popcountsi2 and ctlz_zero_undef calls __clzsi2.
+
+declare i32 @llvm.ctpop.i32(i32) nounwind readnone
+declare i32 @llvm.ctlz.i32(i32, i1) nounwind readnone
+declare i32 @llvm.cttz.i32(i32, i1) nounwind readnone
+
+define i32 @pop(i32 %x) nounwind readnone {
+entry:
+  %r = call i32 @llvm.ctpop.i32(i32 %x)
+  ret i32 %r
+}
+
+; CHECK: pop:
+; CHECK-NOT: call
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 1
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 16
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 63
+; CHECK-NOT: call
+; CHECK: .size pop
+
+; ctlz is a branch-free binary search whose constants all fit in 16 bits.
+define i32 @clz(i32 %x) nounwind readnone {
+entry:
+  %r = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+; CHECK: clz:
+; CHECK-NOT: call
+; CHECK: addui {{r[0-9]+}}, {{r[0-9]+}}, -256
+; CHECK: addui {{r[0-9]+}}, {{r[0-9]+}}, -4096
+; CHECK: addui {{r[0-9]+}}, {{r[0-9]+}}, -16384
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 14
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK-NOT: call
+; CHECK: .size clz
+
+; cttz(x) = 32 - ctlz((x & -x) - 1).
+define i32 @ctz(i32 %x) nounwind readnone {
+entry:
+  %r = call i32 @llvm.cttz.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+; CHECK: ctz:
+; CHECK-NOT: call
+; CHECK: subur r0,
+; CHECK: andr
+; CHECK: addui {{r[0-9]+}}, {{r[0-9]+}}, -1
+; CHECK: addui {{r[0-9]+}}, {{r[0-9]+}}, -256
+; CHECK-NOT: call
+; CHECK: .size ctz
+
+define i32 @pop_os(i32 %x) nounwind readnone optsize {
+entry:
+  %r = call i32 @llvm.ctpop.i32(i32 %x)
+  ret i32 %r
+}
+
+; CHECK: pop_os:
+; CHECK: __popcountsi2
+
+define i32 @clz_os(i32 %x) nounwind readnone optsize {
+entry:
+  %r = call i32 @llvm.ctlz.i32(i32 %x, i1 true)
+  ret i32 %r
+}
+
+; CHECK: clz_os:
+; CHECK: __clzsi2
+
+define i32 @ctz_os(i32 %x) nounwind readnone optsize {
+entry:
+  %r = call i32 @llvm.cttz.i32(i32 %x, i1 true)
+  ret i32 %r
+}
+
+; CHECK: ctz_os:
+; CHECK: __popcountsi2
@@ -0,0 +1,57 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Masks wider than 16 bits are selected as a pair of shifts instead of
+; building the mask in a register.
+
+define i32 @low20(i32 %x) nounwind readnone {
+entry:
+  %r = and i32 %x, 1048575
+  ret i32 %r
+}
+
+; CHECK: low20:
+; CHECK: shlli {{r[0-9]+}}, [[T:r[0-9]+]], 12
+; CHECK: shrli [[T]], {{r[0-9]+}}, 12
+; CHECK: .size low20
+
+; An extract of a shifted field folds the right shift into the pair.
+define i32 @extract(i32 %x) nounwind readnone {
+entry:
+  %s = lshr i32 %x, 4
+  %r = and i32 %s, 1048575
+  ret i32 %r
+}
+
+; CHECK: extract:
+; CHECK: shlli {{r[0-9]+}}, [[T:r[0-9]+]], 8
+; CHECK: shrli [[T]], {{r[0-9]+}}, 12
+; CHECK: .size extract
+
+; Clearing the low bits.
+define i32 @clear_low(i32 %x) nounwind readnone {
+entry:
+  %r = and i32 %x, -256
+  ret i32 %r
+}
+
+; CHECK: clear_low:
+; CHECK: shrli {{r[0-9]+}}, [[T:r[0-9]+]], 8
+; CHECK: shlli [[T]], {{r[0-9]+}}, 8
+; CHECK: .size clear_low
+
+; A field insert (x & ~m) | (y & m) becomes x ^ ((x ^ y) & m), with the mask
+; that fits in andi.
+define i32 @insert(i32 %x, i32 %y) nounwind readnone {
+entry:
+  %a = and i32 %x, -4081
+  %b = and i32 %y, 4080
+  %r = or i32 %a, %b
+  ret i32 %r
+}
+
+; CHECK: insert:
+; CHECK: xorr
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 4080
+; CHECK: xorr
+; CHECK-NOT: {{^[[:space:]]*orr}}
+; CHECK: .size insert
@@ -0,0 +1,79 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Comparisons against zero branch on r0 without materializing the zero.
+
+define void @eq0(i32 %x, i32* %p) nounwind {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %then, label %exit
+
+then:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: eq0:
+; CHECK: {{bne r0, r[0-9]+|be r0, r[0-9]+}}, .LBB
+
+define void @gt0(i32 %x, i32* %p) nounwind {
+entry:
+  %c = icmp sgt i32 %x, 0
+  br i1 %c, label %then, label %exit
+
+then:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; gt0 branches around the store when x <= 0, that is 1 > x.
+; CHECK: gt0:
+; CHECK-NOT: addui r0, {{r[0-9]+}}, 0
+; CHECK: bsgt {{r[0-9]+}}, {{r[0-9]+}}, .LBB
+; CHECK: .size gt0
+
+define void @lt0(i32 %x, i32* %p) nounwind {
+entry:
+  %c = icmp slt i32 %x, 0
+  br i1 %c, label %then, label %exit
+
+then:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: lt0:
+; CHECK: bsgt {{r0, r[0-9]+|r[0-9]+, r0}}, .LBB
+; CHECK: .size lt0
+
+; a >= b has no compare-and-branch. When the false edge falls through, the
+; block branches to the next block on a < b and jumps to the target.
+
+define void @ge(i32 %a, i32 %b, i32* %p) nounwind {
+entry:
+  %c = icmp sge i32 %a, %b
+  br i1 %c, label %far, label %next
+
+next:
+  store volatile i32 1, i32* %p
+  br label %far
+
+far:
+  store volatile i32 2, i32* %p
+  ret void
+}
+
+; CHECK: ge:
+; CHECK: bsgt {{r[0-9]+}}, {{r[0-9]+}}, [[NEXT:.LBB[0-9_]+]]
+; CHECK: be r0, r0, [[FAR:.LBB[0-9_]+]]
+; CHECK: [[NEXT]]:
+; CHECK: [[FAR]]:
+; CHECK: .size ge
@@ -0,0 +1,76 @@
+; RUN: llc -march=azpr -disable-azpr-constant-pool < %s | FileCheck %s
+
+; Constants that need more than one instruction get the shortest sequence
+; the planner finds.
+
+define i32 @simm16() nounwind readnone {
+entry:
+  ret i32 -32768
+}
+
+; CHECK: simm16:
+; CHECK: addui r0, {{r[0-9]+}}, -32768
+
+define i32 @uimm16() nounwind readnone {
+entry:
+  ret i32 65535
+}
+
+; CHECK: uimm16:
+; CHECK: xori r0, {{r[0-9]+}}, 65535
+
+; A 16-bit value shifted left.
+define i32 @shifted() nounwind readnone {
+entry:
+  ret i32 65536
+}
+
+; CHECK: shifted:
+; CHECK: xori r0, [[R:r[0-9]+]], 1
+; CHECK-NEXT: shlli [[R]], [[R]], 16
+
+; A mask of low ones is a sign-extended value shifted right.
+define i32 @mask() nounwind readnone {
+entry:
+  ret i32 16777215
+}
+
+; CHECK: mask:
+; CHECK: addui r0, [[R:r[0-9]+]], -256
+; CHECK-NEXT: shrli [[R]], [[R]], 8
+
+; The upper half is all ones.
+define i32 @upper_ones() nounwind readnone {
+entry:
+  ret i32 -65535
+}
+
+; CHECK: upper_ones:
+; CHECK: addui r0, [[R:r[0-9]+]], -1
+; CHECK-NEXT: xori [[R]], [[R]], 65534
+
+; Nothing shorter exists.
+define i32 @general() nounwind readnone {
+entry:
+  ret i32 305419896
+}
+
+; CHECK: general:
+; CHECK: xori r0, [[R:r[0-9]+]], 4660
+; CHECK-NEXT: shlli [[R]], [[R]], 16
+; CHECK-NEXT: ori [[R]], [[R]], 22136
+
+; A constant close to another one in the block is derived from it.
+define void @derived(i32* %p) nounwind {
+entry:
+  store volatile i32 305419896, i32* %p
+  store volatile i32 305419904, i32* %p
+  ret void
+}
+
+; CHECK: derived:
+; CHECK: xori r0, [[R:r[0-9]+]], 4660
+; CHECK: ori [[R]], [[R]], 22136
+; CHECK-NOT: 22144
+; CHECK: addui [[R]], {{r[0-9]+}}, 8
+; CHECK: .size derived
@@ -0,0 +1,33 @@
+; RUN: opt < %s -cost-model -analyze -mtriple=azpr | FileCheck %s
+
+; Multiply and divide are library calls, ashr and sext are built from
+; several instructions, sub-word accesses go through a word access, and
+; branches pay a delay slot.
+
+define i32 @costs(i32 %a, i32 %b, i8* %p, i32* %q) {
+entry:
+; CHECK: cost of 20 {{.*}} mul
+  %m = mul i32 %a, %b
+; CHECK: cost of 20 {{.*}} udiv
+  %d = udiv i32 %m, %b
+; CHECK: cost of 4 {{.*}} ashr
+  %s = ashr i32 %d, 3
+; CHECK: cost of 1 {{.*}} add
+  %t = add i32 %s, %a
+; CHECK: cost of 6 {{.*}} load i8
+  %c = load i8* %p
+; CHECK: cost of 3 {{.*}} sext
+  %e = sext i8 %c to i32
+; CHECK: cost of 0 {{.*}} trunc
+  %u = trunc i32 %t to i8
+; CHECK: cost of 10 {{.*}} store i8
+  store i8 %u, i8* %p
+; CHECK: cost of 24 {{.*}} load i32* %q, align 2
+  %w = load i32* %q, align 2
+; CHECK: cost of 1 {{.*}} load i32* %q, align 4
+  %x = load i32* %q, align 4
+  %y = add i32 %w, %x
+  %z = add i32 %y, %e
+; CHECK: cost of 2 {{.*}} ret
+  ret i32 %z
+}
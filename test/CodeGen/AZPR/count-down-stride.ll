@@ -0,0 +1,31 @@
+; RUN: llc -march=azpr -disable-azpr-loop-unroll -disable-azpr-runtime-unroll \
+; RUN:   < %s | FileCheck %s
+
+; The counter steps by 4 and is used only by the exit test, so the trip count
+; is a division by 4. It is computed with a shift before the loop, and the
+; loop counts down to r0 without a division call.
+
+define void @fill(i32* %a, i32 %n) nounwind {
+entry:
+  %empty = icmp eq i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %p = phi i32* [ %a, %entry ], [ %p.next, %loop ]
+  store i32 0, i32* %p
+  %p.next = getelementptr inbounds i32* %p, i32 1
+  %i.next = add i32 %i, 4
+  %cmp = icmp ult i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: fill:
+; CHECK-NOT: __udivsi3
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 2
+; CHECK: stw
+; CHECK: addui [[C:r[0-9]+]], [[C]], -1
+; CHECK: bne {{(r0, r[0-9]+|r[0-9]+, r0)}}
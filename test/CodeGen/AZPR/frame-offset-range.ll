@@ -0,0 +1,19 @@
+; RUN: not llc -march=azpr < %s -o /dev/null 2>&1 | FileCheck %s
+
+; %x ends up more than 32KB away from the stack pointer. Its ldw/stw offset
+; cannot be encoded, and the error must also be reported when assertions
+; are compiled out.
+
+declare void @use([16384 x i32]*)
+
+define i32 @far(i32 %v) nounwind {
+entry:
+  %buf = alloca [16384 x i32], align 4
+  %x = alloca i32, align 4
+  store volatile i32 %v, i32* %x
+  call void @use([16384 x i32]* %buf)
+  %r = load volatile i32* %x
+  ret i32 %r
+}
+
+; CHECK: frame offset doesn't fit in 16 bits
@@ -0,0 +1,25 @@
+; RUN: llc -march=azpr -azpr-ssection-threshold=8 < %s | FileCheck %s
+; RUN: llc -march=azpr < %s | FileCheck %s -check-prefix=MERGE
+
+; With small sections on, GlobalMerge must leave small internal globals alone:
+; the merged aggregate would exceed the threshold and move them out of .sdata.
+; Without small sections they are still merged behind one base address.
+
+@a = internal global i32 1
+@b = internal global i32 2
+
+define i32 @sum() nounwind {
+entry:
+  %0 = load i32* @a
+  %1 = load i32* @b
+  %2 = add i32 %0, %1
+  ret i32 %2
+}
+
+; CHECK: sum:
+; CHECK-DAG: ldw {{r[0-9]+}}, gp_rel(a)(r28)
+; CHECK-DAG: ldw {{r[0-9]+}}, gp_rel(b)(r28)
+; CHECK-NOT: _MergedGlobals
+; CHECK: .sdata
+
+; MERGE: _MergedGlobals
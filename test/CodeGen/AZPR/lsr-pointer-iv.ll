@@ -0,0 +1,42 @@
+; RUN: llc -march=azpr -disable-azpr-loop-unroll -disable-azpr-runtime-unroll \
+; RUN:   -disable-azpr-count-down-loops -disable-azpr-software-pipelining \
+; RUN:   < %s | FileCheck %s
+
+; With base + 16-bit offset addressing and only 0 as a free compare
+; immediate, LSR keeps a pointer induction variable stepped by addui and
+; does not scale the index inside the loop. The two loads share the
+; pointer and differ only in the ldw offset.
+
+define i32 @sum(i32* %a, i32 %n) nounwind readonly {
+entry:
+  %empty = icmp eq i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %j = shl i32 %i, 1
+  %p0 = getelementptr inbounds i32* %a, i32 %j
+  %v0 = load i32* %p0, align 4
+  %j1 = or i32 %j, 1
+  %p1 = getelementptr inbounds i32* %a, i32 %j1
+  %v1 = load i32* %p1, align 4
+  %t = add i32 %v0, %v1
+  %s.next = add i32 %s, %t
+  %i.next = add i32 %i, 1
+  %cmp = icmp eq i32 %i.next, %n
+  br i1 %cmp, label %exit, label %loop
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  ret i32 %r
+}
+
+; CHECK: sum:
+; CHECK: [[LOOP:.LBB[0-9_]+]]:
+; CHECK-NOT: shlli
+; CHECK-DAG: ldw {{r[0-9]+}}, 0([[P:r[0-9]+]])
+; CHECK-DAG: ldw {{r[0-9]+}}, 4([[P]])
+; CHECK-DAG: addui [[P]], [[P]], 8
+; CHECK-NOT: shlli
+; CHECK: [[LOOP]]
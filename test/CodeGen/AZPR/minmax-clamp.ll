@@ -0,0 +1,68 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; abs uses the sign mask m = 0 - (x >> 31): (x + m) ^ m.
+
+define i32 @abs(i32 %x) nounwind readnone {
+entry:
+  %neg = sub i32 0, %x
+  %c = icmp sgt i32 %x, -1
+  %r = select i1 %c, i32 %x, i32 %neg
+  ret i32 %r
+}
+
+; CHECK: abs:
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: subur r0,
+; CHECK: addur
+; CHECK: xorr
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size abs
+
+; A signed min/max always selects with a mask.
+
+define i32 @smax(i32 %a, i32 %b) nounwind readnone {
+entry:
+  %c = icmp sgt i32 %a, %b
+  %r = select i1 %c, i32 %a, i32 %b
+  ret i32 %r
+}
+
+; CHECK: smax:
+; CHECK: andr
+; CHECK: xorr
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size smax
+
+; A clamp to [0, 255] is one range test, x >> 8 != 0, and one mask select.
+
+define i32 @clamp_u8(i32 %x) nounwind readnone {
+entry:
+  %c0 = icmp sgt i32 %x, 0
+  %lo = select i1 %c0, i32 %x, i32 0
+  %c1 = icmp slt i32 %lo, 255
+  %r = select i1 %c1, i32 %lo, i32 255
+  ret i32 %r
+}
+
+; CHECK: clamp_u8:
+; CHECK-DAG: shrli {{r[0-9]+}}, {{r[0-9]+}}, 8
+; CHECK-DAG: andi {{r[0-9]+}}, {{r[0-9]+}}, 255
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size clamp_u8
+
+; A clamp to [-128, 127] tests (x ^ m) >> 7 and saturates to m ^ 127.
+
+define i32 @clamp_s8(i32 %x) nounwind readnone {
+entry:
+  %c0 = icmp slt i32 %x, 127
+  %hi = select i1 %c0, i32 %x, i32 127
+  %c1 = icmp sgt i32 %hi, -128
+  %r = select i1 %c1, i32 %hi, i32 -128
+  ret i32 %r
+}
+
+; CHECK: clamp_s8:
+; CHECK-DAG: shrli {{r[0-9]+}}, {{r[0-9]+}}, 7
+; CHECK-DAG: xori {{r[0-9]+}}, {{r[0-9]+}}, 127
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size clamp_s8
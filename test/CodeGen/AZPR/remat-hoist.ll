@@ -0,0 +1,50 @@
+; RUN: llc -march=azpr -disable-azpr-loop-unroll -disable-azpr-runtime-unroll \
+; RUN:   < %s | FileCheck %s
+
+; Addresses and wide constants are single rematerializable pseudos, so
+; MachineLICM moves them out of the loop.
+
+@g = global [4 x i32] zeroinitializer, align 4
+
+define void @fill(i32** %p, i32* %q, i32 %n) nounwind {
+entry:
+  %empty = icmp eq i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %pp = getelementptr inbounds i32** %p, i32 %i
+  store i32* getelementptr inbounds ([4 x i32]* @g, i32 0, i32 0), i32** %pp
+  %qq = getelementptr inbounds i32* %q, i32 %i
+  store i32 305419896, i32* %qq
+  %i.next = add i32 %i, 1
+  %cmp = icmp ult i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: fill:
+; CHECK-DAG: high_a(g)
+; CHECK-DAG: xori r0, {{r[0-9]+}}, 4660
+; CHECK: [[LOOP:.LBB[0-9_]+]]:
+; CHECK-NOT: high_a(g)
+; CHECK-NOT: 4660
+; CHECK: [[LOOP]]
+; CHECK: .size fill
+
+; Two addresses of the same global share one materialization. The second
+; is an addui from the first, or an offset of the same base.
+
+define void @pair(i32 %a, i32 %b) nounwind {
+entry:
+  store volatile i32 %a, i32* getelementptr inbounds ([4 x i32]* @g, i32 0, i32 0)
+  store volatile i32 %b, i32* getelementptr inbounds ([4 x i32]* @g, i32 0, i32 2)
+  ret void
+}
+
+; CHECK: pair:
+; CHECK: high_a(g)
+; CHECK-NOT: high_a(g
+; CHECK: .size pair
@@ -0,0 +1,91 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Rotates are two shifts and an or. A variable rotate computes -n & 31 for
+; the opposite shift.
+
+define i32 @rotl_imm(i32 %x) nounwind readnone {
+entry:
+  %hi = shl i32 %x, 5
+  %lo = lshr i32 %x, 27
+  %r = or i32 %hi, %lo
+  ret i32 %r
+}
+
+; CHECK: rotl_imm:
+; CHECK-DAG: shlli {{r[0-9]+}}, {{r[0-9]+}}, 5
+; CHECK-DAG: shrli {{r[0-9]+}}, {{r[0-9]+}}, 27
+; CHECK: orr
+
+define i32 @rotl_var(i32 %x, i32 %n) nounwind readnone {
+entry:
+  %hi = shl i32 %x, %n
+  %m = sub i32 32, %n
+  %lo = lshr i32 %x, %m
+  %r = or i32 %hi, %lo
+  ret i32 %r
+}
+
+; CHECK: rotl_var:
+; CHECK: subur r0,
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-DAG: shllr
+; CHECK-DAG: shrlr
+; CHECK: orr
+
+; The byte swap uses only 16-bit masks.
+
+declare i32 @llvm.bswap.i32(i32) nounwind readnone
+declare i16 @llvm.bswap.i16(i16) nounwind readnone
+
+define i32 @bswap32(i32 %x) nounwind readnone {
+entry:
+  %r = call i32 @llvm.bswap.i32(i32 %x)
+  ret i32 %r
+}
+
+; CHECK: bswap32:
+; CHECK-NOT: 16711680
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 65280
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 65280
+; CHECK-NOT: 16711680
+; CHECK: .size bswap32
+
+; A hand-written swap with a 0xff0000 mask is recognized and gets the same
+; 16-bit-mask sequence instead of building 0xff0000 in a register.
+
+define i32 @bswap_idiom(i32 %x) nounwind readnone {
+entry:
+  %b3 = shl i32 %x, 24
+  %t2 = shl i32 %x, 8
+  %b2 = and i32 %t2, 16711680
+  %t1 = lshr i32 %x, 8
+  %b1 = and i32 %t1, 65280
+  %b0 = lshr i32 %x, 24
+  %o1 = or i32 %b3, %b2
+  %o2 = or i32 %b1, %b0
+  %r = or i32 %o1, %o2
+  ret i32 %r
+}
+
+; CHECK: bswap_idiom:
+; CHECK-NOT: 16711680
+; CHECK-NOT: 255
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 65280
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 65280
+; CHECK-NOT: 16711680
+; CHECK: .size bswap_idiom
+
+; A 16-bit swap does not go through the 32-bit swap.
+
+define zeroext i16 @bswap16(i16 zeroext %x) nounwind readnone {
+entry:
+  %r = call i16 @llvm.bswap.i16(i16 %x)
+  ret i16 %r
+}
+
+; CHECK: bswap16:
+; CHECK-NOT: shrli {{r[0-9]+}}, {{r[0-9]+}}, 24
+; CHECK-NOT: 65280
+; CHECK: shlli {{r[0-9]+}}, {{r[0-9]+}}, 8
+; CHECK-NOT: shrli {{r[0-9]+}}, {{r[0-9]+}}, 24
+; CHECK: .size bswap16
@@ -0,0 +1,39 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+; RUN: llc -march=azpr -disable-azpr-runtime-unroll < %s \
+; RUN:   | FileCheck %s -check-prefix=NOUNROLL
+
+; The trip count is only known at run time. The loop is unrolled four
+; times after a prolog that runs n & 3 iterations, so no division call is
+; needed. The unrolled stores share one pointer with different offsets.
+
+define void @fill(i32* %a, i32 %n) nounwind {
+entry:
+  %empty = icmp eq i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %p = getelementptr inbounds i32* %a, i32 %i
+  store i32 %i, i32* %p
+  %i.next = add i32 %i, 1
+  %cmp = icmp eq i32 %i.next, %n
+  br i1 %cmp, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; CHECK: fill:
+; CHECK-NOT: __umodsi3
+; CHECK-NOT: __udivsi3
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 3
+; CHECK-DAG: stw {{r[0-9]+}}, 0([[P:r[0-9]+]])
+; CHECK-DAG: stw {{r[0-9]+}}, 4([[P]])
+; CHECK-DAG: stw {{r[0-9]+}}, 8([[P]])
+; CHECK-DAG: stw {{r[0-9]+}}, 12([[P]])
+; CHECK-NOT: __umodsi3
+; CHECK: .size fill
+
+; NOUNROLL: fill:
+; NOUNROLL-NOT: 12(r
+; NOUNROLL: .size fill
@@ -0,0 +1,52 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+; RUN: llc -march=azpr -azpr-select-mask-threshold=12 < %s \
+; RUN:   | FileCheck %s -check-prefix=WIDE
+
+; A select whose comparison is cheap picks its value with a 0/-1 mask:
+; f ^ ((t ^ f) & mask).
+
+define i32 @sel_eq(i32 %a, i32 %b, i32 %t, i32 %f) nounwind readnone {
+entry:
+  %c = icmp eq i32 %a, %b
+  %r = select i1 %c, i32 %t, i32 %f
+  ret i32 %r
+}
+
+; CHECK: sel_eq:
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: andr
+; CHECK: xorr
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size sel_eq
+
+; With a zero arm the mask is applied to the other arm directly.
+define i32 @sel_zero(i32 %a, i32 %b, i32 %t) nounwind readnone {
+entry:
+  %c = icmp slt i32 %a, %b
+  %r = select i1 %c, i32 %t, i32 0
+  ret i32 %r
+}
+
+; CHECK: sel_zero:
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: subur r0,
+; CHECK: andr
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size sel_zero
+
+; An unsigned comparison costs 8 instructions, 12 with the mask, which is
+; over the default threshold of 10. It stays a branch.
+define i32 @sel_ult(i32 %a, i32 %b, i32 %t, i32 %f) nounwind readnone {
+entry:
+  %c = icmp ult i32 %a, %b
+  %r = select i1 %c, i32 %t, i32 %f
+  ret i32 %r
+}
+
+; CHECK: sel_ult:
+; CHECK: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size sel_ult
+
+; WIDE: sel_ult:
+; WIDE-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; WIDE: .size sel_ult
@@ -0,0 +1,81 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Comparison results are computed without branches. The result is the
+; sign bit of a word, shifted down by 31.
+
+define i32 @eq0(i32 %x) nounwind readnone {
+entry:
+  %c = icmp eq i32 %x, 0
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: eq0:
+; CHECK-NOT: xorr
+; CHECK: subur r0,
+; CHECK: orr
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: xori {{r[0-9]+}}, {{r[0-9]+}}, 1
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size eq0
+
+define i32 @ne(i32 %a, i32 %b) nounwind readnone {
+entry:
+  %c = icmp ne i32 %a, %b
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: ne:
+; CHECK: xorr
+; CHECK: subur r0,
+; CHECK: orr
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-NOT: xori
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size ne
+
+; x < 0 is the sign bit itself.
+define i32 @slt0(i32 %x) nounwind readnone {
+entry:
+  %c = icmp slt i32 %x, 0
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: slt0:
+; CHECK-NOT: subur
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size slt0
+
+; a < b corrects the sign of a - b on overflow.
+define i32 @slt(i32 %a, i32 %b) nounwind readnone {
+entry:
+  %c = icmp slt i32 %a, %b
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: slt:
+; CHECK: subur
+; CHECK: xorr
+; CHECK: andr
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size slt
+
+; a >= b is the inverted a < b.
+define i32 @uge(i32 %a, i32 %b) nounwind readnone {
+entry:
+  %c = icmp uge i32 %a, %b
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: uge:
+; CHECK: subur
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: xori {{r[0-9]+}}, {{r[0-9]+}}, 1
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size uge
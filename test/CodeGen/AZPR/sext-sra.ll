@@ -0,0 +1,74 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Sign extension in a register is ((x & mask) ^ signbit) - signbit.
+
+define i32 @sext8(i32 %x) nounwind readnone {
+entry:
+  %t = shl i32 %x, 24
+  %r = ashr i32 %t, 24
+  ret i32 %r
+}
+
+; CHECK: sext8:
+; CHECK: andi {{r[0-9]+}}, [[A:r[0-9]+]], 255
+; CHECK: xori [[A]], [[B:r[0-9]+]], 128
+; CHECK: addui [[B]], {{r[0-9]+}}, -128
+
+define i32 @sext16(i32 %x) nounwind readnone {
+entry:
+  %t = shl i32 %x, 16
+  %r = ashr i32 %t, 16
+  ret i32 %r
+}
+
+; CHECK: sext16:
+; CHECK: andi {{r[0-9]+}}, [[A:r[0-9]+]], 65535
+; CHECK: xori [[A]], [[B:r[0-9]+]], 32768
+; CHECK: addui [[B]], {{r[0-9]+}}, -32768
+
+; An arithmetic shift by 16..31 is a logical shift followed by the same
+; xor/sub with the shifted sign bit.
+
+define i32 @sra20(i32 %x) nounwind readnone {
+entry:
+  %r = ashr i32 %x, 20
+  ret i32 %r
+}
+
+; CHECK: sra20:
+; CHECK: shrli {{r[0-9]+}}, [[A:r[0-9]+]], 20
+; CHECK: xori [[A]], [[B:r[0-9]+]], 2048
+; CHECK: addui [[B]], {{r[0-9]+}}, -2048
+
+; A shift by less than 16 ors the sign mask, built with subur from r0, into
+; the top bits.
+
+define i32 @sra4(i32 %x) nounwind readnone {
+entry:
+  %r = ashr i32 %x, 4
+  ret i32 %r
+}
+
+; CHECK: sra4:
+; CHECK-DAG: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-DAG: shrli {{r[0-9]+}}, {{r[0-9]+}}, 4
+; CHECK-DAG: subur r0,
+; CHECK-DAG: shlli {{r[0-9]+}}, {{r[0-9]+}}, 28
+; CHECK: orr
+
+; An equality test of a sign-extended byte compares the low byte only.
+
+define i32 @cmp8(i32 %x) nounwind readnone {
+entry:
+  %t = shl i32 %x, 24
+  %s = ashr i32 %t, 24
+  %c = icmp eq i32 %s, -1
+  %r = zext i1 %c to i32
+  ret i32 %r
+}
+
+; CHECK: cmp8:
+; CHECK-NOT: xori {{r[0-9]+}}, {{r[0-9]+}}, 128
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, 255
+; CHECK-NOT: xori {{r[0-9]+}}, {{r[0-9]+}}, 128
+; CHECK: .size cmp8
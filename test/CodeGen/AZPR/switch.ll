@@ -0,0 +1,106 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; A dense switch is a jump table: one ldw from the table and a jmp.
+
+define void @dense(i32 %x, i32* %p) nounwind {
+entry:
+  switch i32 %x, label %exit [
+    i32 0, label %c0
+    i32 1, label %c1
+    i32 2, label %c2
+    i32 3, label %c3
+    i32 4, label %c4
+    i32 5, label %c5
+  ]
+
+c0:
+  store volatile i32 10, i32* %p
+  br label %exit
+c1:
+  store volatile i32 11, i32* %p
+  br label %exit
+c2:
+  store volatile i32 12, i32* %p
+  br label %exit
+c3:
+  store volatile i32 13, i32* %p
+  br label %exit
+c4:
+  store volatile i32 14, i32* %p
+  br label %exit
+c5:
+  store volatile i32 15, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: dense:
+; CHECK: bugt
+; CHECK: JTI0_0
+; CHECK: ldw
+; CHECK: jmp {{r[0-9]+}}
+; CHECK: .size dense
+
+; Cases with one destination in a small range are a bit test.
+
+define void @bits(i32 %x, i32* %p) nounwind {
+entry:
+  switch i32 %x, label %exit [
+    i32 1, label %odd
+    i32 3, label %odd
+    i32 5, label %odd
+    i32 7, label %odd
+    i32 9, label %odd
+  ]
+
+odd:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: bits:
+; CHECK: shllr
+; CHECK: andi {{r[0-9]+}}, {{r[0-9]+}}, {{682|341}}
+; CHECK: {{be|bne}} r0,
+; CHECK-NOT: jmp {{r[0-9]+}}
+; CHECK: .size bits
+
+; Sparse cases are a compare tree of compare-and-branch instructions.
+
+define void @sparse(i32 %x, i32* %p) nounwind {
+entry:
+  switch i32 %x, label %exit [
+    i32 1, label %c0
+    i32 100, label %c1
+    i32 1000, label %c2
+    i32 10000, label %c3
+  ]
+
+c0:
+  store volatile i32 10, i32* %p
+  br label %exit
+c1:
+  store volatile i32 11, i32* %p
+  br label %exit
+c2:
+  store volatile i32 12, i32* %p
+  br label %exit
+c3:
+  store volatile i32 13, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: sparse:
+; CHECK-NOT: JTI
+; CHECK: bsgt
+; CHECK: be
+; CHECK-NOT: JTI
+; CHECK: .size sparse
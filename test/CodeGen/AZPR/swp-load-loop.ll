@@ -0,0 +1,44 @@
+; RUN: llc -march=azpr -disable-azpr-loop-unroll -disable-azpr-runtime-unroll \
+; RUN:   -disable-azpr-software-pipelining < %s | FileCheck %s -check-prefix=NOSWP
+; RUN: llc -march=azpr -disable-azpr-loop-unroll -disable-azpr-runtime-unroll \
+; RUN:   < %s | FileCheck %s
+
+; A single-block loop reading one field of a 12-byte struct. Without the
+; pass the load is used right after it is issued. With the pass the value
+; for the next iteration is loaded in the kernel from the current pointer
+; plus the 12-byte stride, folded into the ldw offset. No canonical
+; induction variable or multiply call is introduced.
+
+%struct.S = type { i32, i32, i32 }
+
+define i32 @sum(%struct.S* %a, %struct.S* %end) nounwind readonly {
+entry:
+  %empty = icmp eq %struct.S* %a, %end
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %p = phi %struct.S* [ %a, %entry ], [ %p.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %f = getelementptr inbounds %struct.S* %p, i32 0, i32 1
+  %v = load i32* %f, align 4
+  %s.next = add i32 %s, %v
+  %p.next = getelementptr inbounds %struct.S* %p, i32 1
+  %cmp = icmp eq %struct.S* %p.next, %end
+  br i1 %cmp, label %exit, label %loop
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  ret i32 %r
+}
+
+; NOSWP: sum:
+; NOSWP-NOT: 16(r
+; NOSWP: ldw {{r[0-9]+}}, 4(r
+; NOSWP-NOT: __mulsi3
+
+; CHECK: sum:
+; CHECK: ldw {{r[0-9]+}}, 4(r
+; CHECK-NOT: __mulsi3
+; CHECK: ldw {{r[0-9]+}}, 16(r
+; CHECK-NOT: __mulsi3
+; CHECK: .size sum
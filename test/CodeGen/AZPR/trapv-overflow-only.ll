@@ -0,0 +1,29 @@
+; RUN: llc -march=azpr -azpr-trap-overflow < %s | FileCheck %s
+
+; Only the overflow bit of the add is used. The trapping addsr must survive
+; even though its sum is dead, and it stays between the store before the
+; check and the store after it.
+
+declare {i32, i1} @llvm.sadd.with.overflow.i32(i32, i32) nounwind readnone
+declare void @llvm.trap() noreturn nounwind
+
+define void @check(i32 %a, i32 %b, i32* %p) nounwind {
+entry:
+  store i32 1, i32* %p
+  %t = call {i32, i1} @llvm.sadd.with.overflow.i32(i32 %a, i32 %b)
+  %ovf = extractvalue {i32, i1} %t, 1
+  br i1 %ovf, label %trap, label %cont
+
+trap:
+  call void @llvm.trap()
+  unreachable
+
+cont:
+  store i32 0, i32* %p
+  ret void
+}
+
+; CHECK: check:
+; CHECK: stw
+; CHECK: addsr
+; CHECK: stw
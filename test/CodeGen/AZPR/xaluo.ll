@@ -0,0 +1,67 @@
+; RUN: llc -march=azpr < %s | FileCheck %s
+
+; Overflow flags are the sign bit of a word: shrli 31 for a value, or a
+; bsgt against r0 for a branch. An unsigned add that only feeds a branch
+; compares the sum with an operand in one bugt.
+
+declare {i32, i1} @llvm.sadd.with.overflow.i32(i32, i32) nounwind readnone
+declare {i32, i1} @llvm.ssub.with.overflow.i32(i32, i32) nounwind readnone
+declare {i32, i1} @llvm.uadd.with.overflow.i32(i32, i32) nounwind readnone
+
+define i32 @sadd_flag(i32 %a, i32 %b) nounwind readnone {
+entry:
+  %t = call {i32, i1} @llvm.sadd.with.overflow.i32(i32 %a, i32 %b)
+  %ovf = extractvalue {i32, i1} %t, 1
+  %r = zext i1 %ovf to i32
+  ret i32 %r
+}
+
+; CHECK: sadd_flag:
+; CHECK: addur
+; CHECK: andr
+; CHECK: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK-NOT: {{b(e|ne|sgt|ugt)[[:space:]]}}
+; CHECK: .size sadd_flag
+
+define i32 @ssub_branch(i32 %a, i32 %b, i32* %p) nounwind {
+entry:
+  %t = call {i32, i1} @llvm.ssub.with.overflow.i32(i32 %a, i32 %b)
+  %d = extractvalue {i32, i1} %t, 0
+  %ovf = extractvalue {i32, i1} %t, 1
+  br i1 %ovf, label %overflow, label %exit
+
+overflow:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret i32 %d
+}
+
+; CHECK: ssub_branch:
+; CHECK: subur
+; CHECK: andr
+; CHECK-NOT: shrli {{r[0-9]+}}, {{r[0-9]+}}, 31
+; CHECK: bsgt {{r[0-9]+, r0|r0, r[0-9]+}}, .LBB
+; CHECK: .size ssub_branch
+
+define i32 @uadd_branch(i32 %a, i32 %b, i32* %p) nounwind {
+entry:
+  %t = call {i32, i1} @llvm.uadd.with.overflow.i32(i32 %a, i32 %b)
+  %s = extractvalue {i32, i1} %t, 0
+  %ovf = extractvalue {i32, i1} %t, 1
+  br i1 %ovf, label %overflow, label %exit
+
+overflow:
+  store volatile i32 1, i32* %p
+  br label %exit
+
+exit:
+  ret i32 %s
+}
+
+; CHECK: uadd_branch:
+; CHECK: addur
+; CHECK-NOT: andr
+; CHECK: bugt
+; CHECK: .size uadd_branch
@@ -0,0 +1,13 @@
+; RUN: not llc -march=azpr -code-model=small -filetype=obj < %s -o /dev/null \
+; RUN:   2>&1 | FileCheck %s
+
+; The addend alone already leaves the signed 16-bit window.
+
+@g = external global [16384 x i32]
+
+define i32* @addr() nounwind {
+entry:
+  ret i32* getelementptr inbounds ([16384 x i32]* @g, i32 0, i32 8192)
+}
+
+; CHECK: symbol offset out of range for the small code model
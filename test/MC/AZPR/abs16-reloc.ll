@@ -0,0 +1,45 @@
+; RUN: llc -march=azpr -code-model=small < %s | FileCheck %s -check-prefix=ASM
+; RUN: llc -march=azpr -code-model=small -filetype=obj < %s \
+; RUN:   | elf-dump --dump-section-data | FileCheck %s -check-prefix=OBJ
+
+; Under the small code model a symbol address is one addui from r0, and a
+; load or store of a global uses the address directly as its offset from r0.
+; Both relocations must be R_MIPS_16 (1), which the linker range-checks as a
+; signed 16-bit value, so a symbol placed outside the low 32KB fails to link
+; instead of being truncated.
+
+@g = external global i32
+@a = external global [4 x i32]
+
+define i32* @addr() nounwind {
+entry:
+  ret i32* @g
+}
+
+; ASM: addr:
+; ASM: addui r0, {{r[0-9]+}}, abs(g)
+
+define i32 @load() nounwind {
+entry:
+  %0 = load i32* getelementptr inbounds ([4 x i32]* @a, i32 0, i32 2)
+  ret i32 %0
+}
+
+; ASM: load:
+; ASM-NOT: addui
+; ASM: ldw {{r[0-9]+}}, abs(a+8)(r0)
+
+define void @store(i32 %v) nounwind {
+entry:
+  store i32 %v, i32* @g
+  ret void
+}
+
+; ASM: store:
+; ASM-NOT: addui
+; ASM: stw {{r[0-9]+}}, abs(g)(r0)
+
+; OBJ: '.rel.text'
+; OBJ: ('r_type', 0x01)
+; OBJ: ('r_type', 0x01)
+; OBJ: ('r_type', 0x01)
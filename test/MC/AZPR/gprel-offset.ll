@@ -0,0 +1,24 @@
+; RUN: llc -march=azpr -azpr-ssection-threshold=8 < %s \
+; RUN:   | FileCheck %s -check-prefix=ASM
+; RUN: llc -march=azpr -azpr-ssection-threshold=8 -filetype=obj < %s \
+; RUN:   | elf-dump --dump-section-data | FileCheck %s -check-prefix=OBJ
+
+; A field at a nonzero offset of a small data object is addressed as
+; gp_rel(s+4). Its relocation must be R_MIPS_GPREL16 (7) like the one at
+; offset 0, not R_MIPS_LO16 (6).
+
+@s = global { i32, i32 } { i32 1, i32 2 }
+
+define i32 @second() nounwind {
+entry:
+  %0 = load i32* getelementptr inbounds ({ i32, i32 }* @s, i32 0, i32 1)
+  ret i32 %0
+}
+
+; ASM: second:
+; ASM: ldw {{r[0-9]+}}, gp_rel(s+4)(r28)
+; ASM: .sdata
+
+; OBJ: '.rel.text'
+; OBJ-NOT: ('r_type', 0x06)
+; OBJ: ('r_type', 0x07)
@@ -0,0 +1,41 @@
+; RUN: llc -march=azpr < %s | FileCheck %s -check-prefix=ASM
+; RUN: llc -march=azpr -filetype=obj < %s | elf-dump --dump-section-data \
+; RUN:   | FileCheck %s -check-prefix=OBJ
+
+; The full address (LoadAddr) and a load base (LoadAddrHA) both pair the high
+; half with a sign-extended low half, so both use the adjusted high_a and
+; R_MIPS_HI16. g+0x8004 has bit 15 set: the high half must be 1, not 0.
+
+@g = external global [16384 x i32]
+
+define i32* @addr() nounwind {
+entry:
+  ret i32* getelementptr inbounds ([16384 x i32]* @g, i32 0, i32 8193)
+}
+
+; ASM: addr:
+; ASM: ori r0, [[R:r[0-9]+]], high_a({{.*}}g{{.*}}32772{{.*}})
+; ASM: shlli [[R]], [[R]], 16
+; ASM: addui [[R]], [[R]], low({{.*}}g{{.*}}32772{{.*}})
+
+define i32 @load() nounwind {
+entry:
+  %0 = load i32* getelementptr inbounds ([16384 x i32]* @g, i32 0, i32 8193)
+  ret i32 %0
+}
+
+; ASM: load:
+; ASM: ori r0, [[B:r[0-9]+]], high_a({{.*}}g{{.*}}32772{{.*}})
+; ASM: shlli [[B]], [[B]], 16
+; ASM: ldw {{r[0-9]+}}, low(g+32772)([[B]])
+
+; Each high half is an ori from r0 with the adjusted value 1.
+; OBJ: '.text'
+; OBJ: '_section_data', '{{.*}}0c{{[01][0-9a-f]}}0001{{.*}}0c{{[01][0-9a-f]}}0001
+
+; Each R_MIPS_HI16 (5) is followed by its R_MIPS_LO16 (6).
+; OBJ: '.rel.text'
+; OBJ: ('r_type', 0x05)
+; OBJ: ('r_type', 0x06)
+; OBJ: ('r_type', 0x05)
+; OBJ: ('r_type', 0x06)
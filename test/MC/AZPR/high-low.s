@@ -0,0 +1,18 @@
+# RUN: llvm-mc -triple azpr -show-encoding < %s | FileCheck %s
+# RUN: llvm-mc -triple azpr -filetype=obj < %s | elf-dump \
+# RUN:   | FileCheck %s -check-prefix=OBJ
+
+# high() is the plain upper half for an ori pair. high_a() is adjusted for a
+# low half that is added with sign extension.
+
+	ori	$r0, $r1, %high(0x12348000)
+# CHECK: encoding: [0x0c,0x01,0x12,0x34]
+	ori	$r0, $r1, %high_a(0x12348000)
+# CHECK: encoding: [0x0c,0x01,0x12,0x35]
+
+# A relocated high_a() is R_MIPS_HI16 (5), paired with R_MIPS_LO16 (6).
+	ori	$r0, $r1, %high_a(g)
+	addui	$r1, $r1, %low(g)
+# OBJ: '.rel.text'
+# OBJ: ('r_type', 0x05)
+# OBJ: ('r_type', 0x06)
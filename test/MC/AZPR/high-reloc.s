@@ -0,0 +1,9 @@
+# RUN: not llvm-mc -triple azpr -filetype=obj < %s -o /dev/null 2>&1 \
+# RUN:   | FileCheck %s
+
+# The linker always adjusts R_MIPS_HI16, so an unadjusted high() of a
+# symbol has no relocation.
+
+	ori	$r0, $r1, %high(g)
+	ori	$r1, $r1, %low(g)
+# CHECK: high() cannot be relocated